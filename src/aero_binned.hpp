@@ -10,7 +10,7 @@
 #include "aero_data.hpp"
 #include "bin_grid.hpp"
 #include "aero_dist.hpp"
-#include "aero_data.hpp"
+#include "ndarray_output.hpp"
 
 extern "C" void f_aero_binned_ctor(void *ptr) noexcept;
 extern "C" void f_aero_binned_dtor(void *ptr) noexcept;
@@ -33,11 +33,12 @@ extern "C" void f_aero_binned_num_conc(
     double *num_conc,
     const int *len
 ) noexcept;
-extern "C" void f_aero_binned_species_vol_conc(
+extern "C" void f_aero_binned_vol_conc(
     const void *ptr,
     double *data,
     const int *n_bins,
-    const int *i_spec
+    const int *n_spec,
+    const bool *transposed
 ) noexcept;
     
 struct AeroBinned {
@@ -77,30 +78,30 @@ struct AeroBinned {
         return num_conc;
     }
 
-    static auto vol_conc(const AeroBinned &self){
-
-        int len;
+    static auto vol_conc(const AeroBinned &self, const bool &transposed = false) {
+        int n_bins;
         f_aero_binned_len(
             self.ptr.f_arg(),
-            &len
+            &n_bins
         );
+        const int n_spec = AeroData::__len__(*self.aero_data);
+        std::valarray<double> vol_conc(n_bins * n_spec);
 
-        int cols = len;
-        int rows;
-        f_aero_data_len(self.aero_data->ptr.f_arg(), &rows);
+        f_aero_binned_vol_conc(
+            self.ptr.f_arg(),
+            begin(vol_conc),
+            &n_bins,
+            &n_spec,
+            &transposed
+        );
 
-        std::valarray<std::valarray<double>> vol_conc(rows);
-        std::valarray<double> vol_species(cols);
-        for (int i = 0; i < rows; i++) {
-           vol_conc[i] = std::valarray<double>(cols);
-           f_aero_binned_species_vol_conc(self.ptr.f_arg(), begin(vol_species), &cols, &i);
-           for (int j = 0; j < cols; ++j) {
-                vol_conc[i][j] = vol_species[j];
-           } 
-       }
-  
-       return vol_conc;
+        return transposed
+            ? matrix_output(std::move(vol_conc), n_bins, n_spec)
+            : matrix_output(std::move(vol_conc), n_spec, n_bins);
+    }
 
+    static auto vol_conc_transposed(const AeroBinned &self) {
+        return vol_conc(self, true);
     }
 
     static void add_aero_dist(AeroBinned &self, 
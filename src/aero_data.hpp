@@ -10,11 +10,13 @@
 #include "json_resource.hpp"
 #include "aero_data_parameters.hpp"
 #include "nanobind/nanobind.h"
+#include "ndarray_output.hpp"
+#include "spec_index.hpp"
+#include <cmath>
 
 extern "C" void f_aero_data_ctor(void *ptr) noexcept;
 extern "C" void f_aero_data_dtor(void *ptr) noexcept;
 extern "C" void f_aero_data_from_json(const void *ptr) noexcept;
-extern "C" void f_aero_data_spec_by_name(const void *ptr, int *value, const char *name_data, const int *name_size) noexcept;
 extern "C" void f_aero_data_len(const void *ptr, int *len) noexcept;
 extern "C" void f_aero_data_n_source(const void *ptr, int *len) noexcept;
 extern "C" void f_aero_data_set_frac_dim(void *ptr, const double*) noexcept;
@@ -37,6 +39,7 @@ extern "C" void f_aero_data_spec_name_by_index(const void *ptr, const int *i_spe
 
 struct AeroData {
     PMCResource ptr;
+    LazySpecIndex spec_index_cache;
 
     AeroData(const nlohmann::json &json) :
         ptr(f_aero_data_ctor, f_aero_data_dtor)
@@ -53,18 +56,23 @@ struct AeroData {
         ptr(f_aero_data_ctor, f_aero_data_dtor)
     {}
 
+    static const SpecIndex &spec_index(const AeroData &self) {
+        return self.spec_index_cache.get([&]() {
+            char name[AERO_NAME_LEN];
+            return SpecIndex(__len__(self), [&](const int &idx) {
+                f_aero_data_spec_name_by_index(self.ptr.f_arg(), &idx, name);
+                return std::string(name);
+            });
+        });
+    }
+
     static auto spec_by_name(const AeroData &self, const std::string &name) {
-        int value;
-        const int name_size = name.size();
-        f_aero_data_spec_by_name(
-            self.ptr.f_arg(),
-            &value,
-            name.c_str(),
-            &name_size
-        );
-        if (value==0)
-            throw std::runtime_error("Element not found.");
-        return value - 1;
+        return spec_index(self).at(name);
+    }
+
+    static auto spec_indices(const AeroData &self, const std::vector<std::string> &names) {
+        const auto indices = spec_index(self).at(names);
+        return valarray_output(std::valarray<int>(indices.data(), indices.size()));
     }
 
     static std::size_t __len__(const AeroData &self) {
@@ -164,6 +172,57 @@ struct AeroData {
         return diam;
     }
 
+    // fractal (Naumann 2003) power law coefficients, obtained once per array conversion:
+    // vol = rad2vol_coef * rad^frac_dim and rad = vol2rad_coef * vol^(1 / frac_dim)
+    struct FractalCoefs {
+        double frac_dim, rad2vol_coef, vol2rad_coef;
+    };
+
+    static FractalCoefs fractal_coefs(const AeroData &self) {
+        double frac_dim, vol_fill_factor, prime_radius;
+        f_aero_data_get_frac_dim(self.ptr.f_arg(), &frac_dim);
+        f_aero_data_get_vol_fill_factor(self.ptr.f_arg(), &vol_fill_factor);
+        f_aero_data_get_prime_radius(self.ptr.f_arg(), &prime_radius);
+
+        const double pi = 3.14159265358979323846;
+        const double prime_vol = 4 * pi / 3 * std::pow(prime_radius, 3);
+        return FractalCoefs{
+            frac_dim,
+            prime_vol / vol_fill_factor / std::pow(prime_radius, frac_dim),
+            prime_radius * std::pow(vol_fill_factor / prime_vol, 1 / frac_dim)
+        };
+    }
+
+    static auto rad2vol_array(const AeroData &self, const ConstDoubleArray &radii) {
+        const auto coefs = fractal_coefs(self);
+        return map_array(radii, [&](double rad) {
+            return coefs.rad2vol_coef * std::pow(rad, coefs.frac_dim);
+        });
+    }
+
+    static auto vol2rad_array(const AeroData &self, const ConstDoubleArray &vols) {
+        const auto coefs = fractal_coefs(self);
+        const double exponent = 1 / coefs.frac_dim;
+        return map_array(vols, [&](double vol) {
+            return coefs.vol2rad_coef * std::pow(vol, exponent);
+        });
+    }
+
+    static auto diam2vol_array(const AeroData &self, const ConstDoubleArray &diams) {
+        const auto coefs = fractal_coefs(self);
+        return map_array(diams, [&](double diam) {
+            return coefs.rad2vol_coef * std::pow(diam / 2, coefs.frac_dim);
+        });
+    }
+
+    static auto vol2diam_array(const AeroData &self, const ConstDoubleArray &vols) {
+        const auto coefs = fractal_coefs(self);
+        const double exponent = 1 / coefs.frac_dim;
+        return map_array(vols, [&](double vol) {
+            return 2 * coefs.vol2rad_coef * std::pow(vol, exponent);
+        });
+    }
+
     static auto densities(const AeroData &self) {
         int len;
         f_aero_data_len(
@@ -184,21 +243,9 @@ struct AeroData {
     }
 
     static auto density(const AeroData &self, const std::string &name) {
-        int idx;
+        const int idx = spec_by_name(self, name);
         double data;
-        const int name_size = name.size();
-
-        f_aero_data_spec_by_name(
-            self.ptr.f_arg(),
-            &idx,
-            name.c_str(),
-            &name_size
-        );
-
-        if (idx==0)
-            throw std::runtime_error("Element not found.");
 
-        idx--;
         f_aero_data_get_species_density(
             self.ptr.f_arg(),
             &idx,
@@ -0,0 +1,186 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#pragma once
+
+#include "aero_particle.hpp"
+#include "aero_state.hpp"
+#include "env_state.hpp"
+
+// refers to a particle stored in an AeroState instead of copying it out, the referring
+// AeroState is kept alive by the bindings and any change of its particle count or ordering
+// (tracked with AeroState::generation) invalidates the view
+struct AeroParticleView {
+    const AeroState *aero_state;
+    int index;
+    uint64_t generation;
+
+    AeroParticleView(
+        const AeroState &aero_state,
+        const int &index
+    ) :
+        aero_state(&aero_state),
+        index(index),
+        generation(aero_state.generation)
+    {
+        if (index < 0 || index >= (int)AeroState::__len__(aero_state))
+            throw std::out_of_range("Index out of range");
+    }
+
+    static void *particle_ptr(const AeroParticleView &self) {
+        if (self.generation != self.aero_state->generation)
+            throw std::runtime_error("AeroParticleView invalidated by a change of the AeroState");
+        void *ptr;
+        f_aero_state_particle_ptr(
+            self.aero_state->ptr.f_arg(),
+            &self.index,
+            &ptr
+        );
+        return ptr;
+    }
+
+    static bool valid(const AeroParticleView &self) {
+        return self.generation == self.aero_state->generation;
+    }
+
+    static auto volumes(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        int len = AeroData::__len__(*self.aero_state->aero_data);
+        std::valarray<double> data(len);
+        f_aero_particle_volumes(
+            &ptr,
+            begin(data),
+            &len
+        );
+        return data;
+    }
+
+    static auto volume(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        double vol;
+        f_aero_particle_volume(
+            &ptr,
+            &vol
+        );
+        return vol;
+    }
+
+    static auto dry_volume(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        double vol;
+        f_aero_particle_dry_volume(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            &vol
+        );
+        return vol;
+    }
+
+    static auto radius(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        double radius;
+        f_aero_particle_radius(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            &radius
+        );
+        return radius;
+    }
+
+    static auto dry_radius(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        double radius;
+        f_aero_particle_dry_radius(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            &radius
+        );
+        return radius;
+    }
+
+    static auto diameter(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        double diameter;
+        f_aero_particle_diameter(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            &diameter
+        );
+        return diameter;
+    }
+
+    static auto dry_diameter(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        double diameter;
+        f_aero_particle_dry_diameter(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            &diameter
+        );
+        return diameter;
+    }
+
+    static auto mass(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        double mass;
+        f_aero_particle_mass(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            &mass
+        );
+        return mass;
+    }
+
+    static auto density(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        double density;
+        f_aero_particle_density(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            &density
+        );
+        return density;
+    }
+
+    static auto id(const AeroParticleView &self) {
+        void *ptr = particle_ptr(self);
+        int64_t val;
+        f_aero_particle_id(
+            &ptr,
+            &val
+        );
+        return val;
+    }
+
+    static auto mobility_diameter(const AeroParticleView &self, const EnvState &env_state) {
+        void *ptr = particle_ptr(self);
+        double mobility_diameter;
+        f_aero_particle_mobility_diameter(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            env_state.ptr.f_arg(),
+            &mobility_diameter
+        );
+        return mobility_diameter;
+    }
+
+    static auto crit_rel_humid(const AeroParticleView &self, const EnvState &env_state) {
+        void *ptr = particle_ptr(self);
+        double crit_rel_humid;
+        f_aero_particle_crit_rel_humid(
+            &ptr,
+            self.aero_state->aero_data->ptr.f_arg(),
+            env_state.ptr.f_arg(),
+            &crit_rel_humid
+        );
+        return crit_rel_humid;
+    }
+
+    static AeroParticle* copy(const AeroParticleView &self) {
+        particle_ptr(self);
+        return AeroState::get_particle(*self.aero_state, self.index);
+    }
+};
@@ -12,8 +12,12 @@
 #include "aero_particle.hpp"
 #include "env_state.hpp"
 #include "bin_grid.hpp"
+#include "ndarray_output.hpp"
+#include "rand.hpp"
+#include "util.hpp"
 #include "tl/optional.hpp"
 // #include <optional>
+#include <algorithm>
 #include <vector>
 
 extern "C" void f_aero_state_ctor(
@@ -141,6 +145,12 @@ extern "C" void f_aero_state_particle(
     const int *index
 ) noexcept;
 
+extern "C" void f_aero_state_particle_ptr(
+    const void *ptr_c,
+    const int *index,
+    void **ptr_particle_c
+) noexcept;
+
 extern "C" void f_aero_state_rand_particle(
     const void *ptr_c,
     const void *ptr_particle_c
@@ -163,6 +173,11 @@ extern "C" void f_aero_state_add_particle(
     const void *ptr_aero_particle_c
 ) noexcept;
 
+extern "C" void f_aero_state_copy(
+    const void *ptr_c,
+    void *ptr_aero_state_to_c
+) noexcept;
+
 extern "C" void f_aero_state_copy_weight(
     const void *ptr_c,
     void *ptr_aero_state_to_c
@@ -177,6 +192,11 @@ extern "C" void f_aero_state_zero(
     void *ptr_c
 ) noexcept;
 
+// clears the removals recorded (with record_removals) since the last output
+extern "C" void f_aero_state_zero_removals(
+    void *ptr_c
+) noexcept;
+
 extern "C" void f_aero_state_ids(
     const void *ptr_c,
     int64_t *ids,
@@ -209,6 +229,47 @@ extern "C" void f_aero_state_sample_particles(
      const double *sample_prob
 ) noexcept;
 
+extern "C" void f_aero_state_extract(
+    const void *ptr_c,
+    const void *aero_data_ptr,
+    const void *env_state_ptr,
+    const int *use_species,
+    const int *n_spec,
+    const char *fields,
+    const int *n_fields,
+    double *data,
+    int64_t *ids,
+    const int *n_parts
+) noexcept;
+
+extern "C" void f_aero_state_columns(
+    const void *ptr_c,
+    const void *aero_data_ptr,
+    int64_t *ids,
+    double *num_concs,
+    double *least_create_times,
+    double *greatest_create_times,
+    double *volumes,
+    int *sources,
+    const int *n_spec,
+    const int *n_source,
+    const int *n_parts
+) noexcept;
+
+extern "C" void f_aero_state_species_volumes(
+    const void *ptr_c,
+    double *volumes,
+    const int *n_spec,
+    const int *n_parts
+) noexcept;
+
+extern "C" void f_aero_state_set_species_volumes(
+    void *ptr_c,
+    const double *volumes,
+    const int *n_spec,
+    const int *n_parts
+) noexcept;
+
 template <typename arr_t, typename arg_t>
 auto pointer_vec_magic(arr_t &data_vec, const arg_t &arg) {
     std::vector<char*> pointer_vec(data_vec.size());
@@ -226,6 +287,10 @@ struct AeroState {
     PMCResource ptr;
     std::shared_ptr<AeroData> aero_data;
     int allow_halving = -1, allow_doubling = -1;
+    uint64_t generation = 0;  // incremented on changes invalidating particle indices
+    // if set, used instead of the thread's generator (accessed with std::atomic_load/store as
+    // run_part*() read it with the GIL released)
+    std::shared_ptr<RandomState> random_state;
 
     AeroState(
         std::shared_ptr<AeroData> aero_data,
@@ -314,7 +379,7 @@ struct AeroState {
             &len
         );
 
-        return num_concs;
+        return valarray_output(std::move(num_concs));
     }
 
     static auto masses(
@@ -347,7 +412,7 @@ struct AeroState {
             pointer_vec_magic(exclude_arr, exclude).data()
         );
 
-        return masses;
+        return valarray_output(std::move(masses));
     }
 
     static auto dry_diameters(const AeroState &self) {
@@ -365,7 +430,7 @@ struct AeroState {
             &len
         );
 
-        return dry_diameters;
+        return valarray_output(std::move(dry_diameters));
     }
 
     static auto mobility_diameters(const AeroState &self, const EnvState &env_state) {
@@ -384,7 +449,7 @@ struct AeroState {
             &len
         );
 
-        return mobility_diameters;
+        return valarray_output(std::move(mobility_diameters));
     }
 
     static auto diameters(
@@ -417,7 +482,7 @@ struct AeroState {
             pointer_vec_magic(exclude_arr, exclude).data()
         );
 
-        return diameters;
+        return valarray_output(std::move(diameters));
     }
 
     static auto volumes(
@@ -450,7 +515,7 @@ struct AeroState {
             pointer_vec_magic(exclude_arr, exclude).data()
         );
 
-        return volumes;
+        return valarray_output(std::move(volumes));
     }
 
     static auto crit_rel_humids(
@@ -472,7 +537,227 @@ struct AeroState {
             &len
         );
 
-        return crit_rel_humids;
+        return valarray_output(std::move(crit_rel_humids));
+    }
+
+    static auto species_mask(
+        const AeroState &self,
+        const tl::optional<std::vector<std::string>> &include,
+        const tl::optional<std::vector<std::string>> &exclude
+    ) {
+        std::valarray<int> use_species(
+            include.has_value() ? 0 : 1,
+            AeroData::__len__(*self.aero_data)
+        );
+        if (include.has_value())
+            for (const auto &name : include.value())
+                use_species[AeroData::spec_by_name(*self.aero_data, name)] = 1;
+        if (exclude.has_value())
+            for (const auto &name : exclude.value())
+                use_species[AeroData::spec_by_name(*self.aero_data, name)] = 0;
+        return use_species;
+    }
+
+    static auto field_codes(
+        const std::map<std::string, char> &field_c,
+        const std::vector<std::string> &fields,
+        const EnvState *env_state
+    ) {
+        std::vector<char> fields_c;
+        for (const auto &field : fields) {
+            if (field_c.find(field) == field_c.end()) {
+                std::ostringstream msg;
+                msg << "unknown field '" << field << "', valid options are: ";
+                auto index = 0;
+                for (auto const& pair: field_c)
+                    msg << (!index++ ? "" : ", ") << pair.first;
+                throw std::runtime_error(msg.str());
+            }
+            const auto code = field_c.at(field);
+            if ((code == 'b' || code == 'c') && env_state == nullptr)
+                throw std::runtime_error("field '" + field + "' requires env_state");
+            fields_c.push_back(code);
+        }
+        return fields_c;
+    }
+
+    // one column of __len__() values per field, filled in a single pass over the particles;
+    // the particle IDs (field 'i') go to ids (of __len__() values), their column is left zero
+    static auto extract_columns(
+        const AeroState &self,
+        const std::vector<char> &fields_c,
+        const tl::optional<std::vector<std::string>> &include,
+        const tl::optional<std::vector<std::string>> &exclude,
+        const EnvState *env_state,
+        int64_t *ids = nullptr
+    ) {
+        const int len = __len__(self);
+        const int n_fields = fields_c.size();
+        const auto use_species = species_mask(self, include, exclude);
+        const int n_spec = use_species.size();
+        const void *no_env_state = nullptr;
+
+        std::valarray<double> data(len * n_fields);
+        f_aero_state_extract(
+            self.ptr.f_arg(),
+            self.aero_data->ptr.f_arg(),
+            env_state != nullptr ? env_state->ptr.f_arg() : &no_env_state,
+            begin(use_species),
+            &n_spec,
+            fields_c.data(),
+            &n_fields,
+            begin(data),
+            ids,
+            &len
+        );
+        return data;
+    }
+
+    static const std::map<std::string, char> &extract_field_codes() {
+        static const std::map<std::string, char> field_c{
+          {"num_concs", 'n'},
+          {"masses", 'm'},
+          {"volumes", 'v'},
+          {"diameters", 'd'},
+          {"dry_diameters", 'D'},
+          {"mobility_diameters", 'b'},
+          {"crit_rel_humids", 'c'},
+          {"kappas", 'k'},
+          {"ids", 'i'},
+        };
+        return field_c;
+    }
+
+    static auto extract(
+        const AeroState &self,
+        const std::vector<std::string> &fields,
+        const tl::optional<std::vector<std::string>> &include,
+        const tl::optional<std::vector<std::string>> &exclude,
+        const EnvState *env_state
+    ) {
+        const auto fields_c = field_codes(extract_field_codes(), fields, env_state);
+        const int len = __len__(self);
+        const int n_fields = fields_c.size();
+        const bool with_ids = std::find(fields_c.begin(), fields_c.end(), 'i') != fields_c.end();
+        std::valarray<int64_t> ids(with_ids ? len : 0);
+        auto data = extract_columns(self, fields_c, include, exclude, env_state,
+            with_ids ? begin(ids) : nullptr);
+
+        // IDs are kept as 64-bit integers (not exactly representable as doubles above 2^53)
+        nanobind::dict columns;
+        if (list_output()) {
+            for (int i = 0; i < n_fields; ++i)
+                columns[fields[i].c_str()] = fields_c[i] == 'i'
+                    ? valarray_output(std::valarray<int64_t>(ids))
+                    : valarray_output(std::valarray<double>(data[std::slice(i * len, len, 1)]));
+            return columns;
+        }
+        auto buffer = valarray_owner(std::move(data));
+        for (int i = 0; i < n_fields; ++i) {
+            if (fields_c[i] == 'i')
+                columns[fields[i].c_str()] = valarray_output(std::valarray<int64_t>(ids));
+            else
+                columns[fields[i].c_str()] = ndarray_view(
+                    buffer.first + i * len, {size_t(len)}, buffer.second
+                );
+        }
+        return columns;
+    }
+
+    static nanobind::object histogram(
+        const AeroState &self,
+        const std::string &x,
+        const BinGrid &x_grid,
+        const tl::optional<std::string> &y,
+        const BinGrid *y_grid,
+        const std::string &weight,
+        const tl::optional<std::vector<std::string>> &include,
+        const tl::optional<std::vector<std::string>> &exclude,
+        const EnvState *env_state,
+        const int &n_threads
+    ) {
+        static const std::map<std::string, char> quantity_c{
+          {"mass", 'm'},
+          {"volume", 'v'},
+          {"diameter", 'd'},
+          {"dry_diameter", 'D'},
+          {"mobility_diameter", 'b'},
+          {"crit_rel_humid", 'c'},
+          {"kappa", 'k'},
+        };
+        static const std::map<std::string, char> weight_c{
+          {"num_conc", 'n'},
+          {"mass_conc", 'm'},
+          {"volume_conc", 'v'},
+        };
+
+        if (y.has_value() != (y_grid != nullptr))
+            throw std::runtime_error("y and y_grid must be given together");
+
+        // columns: x, [y,] num_conc [, mass or volume]
+        std::vector<std::string> quantities{x};
+        if (y.has_value())
+            quantities.push_back(y.value());
+        auto fields_c = field_codes(quantity_c, quantities, env_state);
+        const auto weight_code = field_codes(weight_c, {weight}, env_state)[0];
+        fields_c.push_back('n');
+        if (weight_code != 'n')
+            fields_c.push_back(weight_code);
+
+        const size_t len = __len__(self);
+        const auto data = extract_columns(self, fields_c, include, exclude, env_state);
+        const double *num_concs = begin(data) + quantities.size() * len;
+        std::valarray<double> weights(num_concs, len);
+        if (weight_code != 'n')
+            weights *= std::valarray<double>(num_concs + len, len);
+
+        const tcb::span<const double> x_values(begin(data), len);
+        const tcb::span<const double> weight_values(begin(weights), len);
+        if (!y.has_value())
+            return valarray_output(histogram_1d(x_grid, x_values, weight_values, n_threads));
+        const tcb::span<const double> y_values(begin(data) + len, len);
+        return histogram_2d(x_grid, x_values, *y_grid, y_values, weight_values, n_threads);
+    }
+
+    static auto species_volumes(const AeroState &self) {
+        int len;
+        f_aero_state_len(
+            self.ptr.f_arg(),
+            &len
+        );
+        const int n_spec = AeroData::__len__(*self.aero_data);
+        std::valarray<double> volumes(len * n_spec);
+
+        f_aero_state_species_volumes(
+            self.ptr.f_arg(),
+            begin(volumes),
+            &n_spec,
+            &len
+        );
+
+        return matrix_output(std::move(volumes), len, n_spec);
+    }
+
+    static void set_species_volumes(
+        AeroState &self,
+        const nanobind::ndarray<const double, nanobind::ndim<2>, nanobind::c_contig, nanobind::device::cpu> &volumes
+    ) {
+        int len;
+        f_aero_state_len(
+            self.ptr.f_arg(),
+            &len
+        );
+        const int n_spec = AeroData::__len__(*self.aero_data);
+
+        if (volumes.shape(0) != size_t(len) || volumes.shape(1) != size_t(n_spec))
+            throw std::runtime_error("volumes must be of shape (n_part, n_spec)");
+
+        f_aero_state_set_species_volumes(
+            self.ptr.f_arg_non_const(),
+            volumes.data(),
+            &n_spec,
+            &len
+        );
     }
 
     static void make_dry(
@@ -498,7 +783,7 @@ struct AeroState {
             &len
         );
 
-        return ids;
+        return valarray_output(std::move(ids));
     }
 
     static auto mixing_state(
@@ -576,6 +861,7 @@ struct AeroState {
         std::valarray<double> data(len);
 
         AeroParticle *ptr = new AeroParticle(self.aero_data, data);
+        RandomStateGuard guard(std::atomic_load(&self.random_state));
         f_aero_state_rand_particle(self.ptr.f_arg(), ptr);
 
         return ptr;
@@ -600,6 +886,10 @@ struct AeroState {
        self.allow_doubling = allow_doubling;
        self.allow_halving = allow_halving;
 
+       // the new particles take their IDs from PartMC's module-level counter (see solver_lock(),
+       // called with the GIL released as run_part*() may wait for the GIL holding the lock)
+       auto serial = solver_lock();
+       RandomStateGuard guard(std::atomic_load(&self.random_state));
        f_aero_state_add_aero_dist_sample(
            self.ptr.f_arg(),
            self.aero_data->ptr.f_arg(),
@@ -610,6 +900,7 @@ struct AeroState {
            &allow_halving,
            &n_part_add
        );
+       ++self.generation;
        return n_part_add;
    }
 
@@ -622,7 +913,7 @@ struct AeroState {
             self.aero_data->ptr.f_arg(),
             particle.ptr.f_arg()
        );
-
+       ++self.generation;
    } 
 
    static void copy_weight(
@@ -640,12 +931,14 @@ struct AeroState {
       const int &i_part
    ) {
      f_aero_state_remove_particle(self.ptr.f_arg_non_const(), &i_part);
+     ++self.generation;
    }
 
    static void zero(
       AeroState &self
    ) {
       f_aero_state_zero(self.ptr.f_arg_non_const());
+      ++self.generation;
    }
 
    static void add(
@@ -656,6 +949,7 @@ struct AeroState {
             delta.ptr.f_arg(),
             self.aero_data->ptr.f_arg()
       );
+      ++self.generation;
    }
 
    static void add_particles(
@@ -666,6 +960,7 @@ struct AeroState {
             delta.ptr.f_arg(),
             self.aero_data->ptr.f_arg()
       );
+      ++self.generation;
    }
 
    static void sample(
@@ -673,11 +968,14 @@ struct AeroState {
        AeroState &aero_state_sample,
        const double sample_prob
    )  {
+        RandomStateGuard guard(std::atomic_load(&self.random_state));
         f_aero_state_sample(self.ptr.f_arg_non_const(),
             aero_state_sample.ptr.f_arg_non_const(),
             self.aero_data->ptr.f_arg(),
             &sample_prob
       );
+      ++self.generation;
+      ++aero_state_sample.generation;
    }
 
    static void sample_particles(
@@ -685,10 +983,13 @@ struct AeroState {
        AeroState &aero_state_sample,
        const double sample_prob
    )  {
+        RandomStateGuard guard(std::atomic_load(&self.random_state));
         f_aero_state_sample_particles(self.ptr.f_arg_non_const(),
             aero_state_sample.ptr.f_arg_non_const(),
             self.aero_data->ptr.f_arg(),
             &sample_prob
       );
+      ++self.generation;
+      ++aero_state_sample.generation;
    }
 };
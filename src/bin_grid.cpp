@@ -4,70 +4,145 @@
 # Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
 ##################################################################################################*/
 
+#include <algorithm>
+#include <thread>
 #include "bin_grid.hpp"
 
+template <typename Fill>
+static void parallel_fill(
+    const size_t &n_data,
+    const size_t &hist_size,
+    const int &n_threads,
+    double *hist,
+    Fill fill
+) {
+    if (n_threads < 0)
+        throw std::runtime_error("n_threads must be non-negative");
+
+    // below this many values per thread the partial histograms cost more than they save
+    const size_t min_chunk = 1 << 16;
+    const size_t n_workers = std::max<size_t>(1, std::min<size_t>(
+        n_threads > 0 ? n_threads : std::max(1u, std::thread::hardware_concurrency()),
+        n_data / min_chunk
+    ));
+
+    nb::gil_scoped_release release;
+    if (n_workers == 1) {
+        fill(0, n_data, hist);
+        return;
+    }
+
+    const size_t chunk = (n_data + n_workers - 1) / n_workers;
+    std::vector<std::valarray<double>> partials(n_workers - 1, std::valarray<double>(0., hist_size));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n_workers; ++i)
+        threads.emplace_back([&, i]() {
+            fill(i * chunk, std::min(n_data, (i + 1) * chunk), begin(partials[i - 1]));
+        });
+    fill(0, chunk, hist);
+    for (auto &thread : threads)
+        thread.join();
+
+    for (const auto &partial : partials)
+        for (size_t i = 0; i < hist_size; ++i)
+            hist[i] += partial[i];
+}
+
 std::valarray<double> histogram_1d(
     const BinGrid &bin_grid,
-    std::valarray<double> values,
-    std::valarray<double> weights
+    const tcb::span<const double> &values,
+    const tcb::span<const double> &weights,
+    const int &n_threads
 ) {
+    if (values.size() != weights.size())
+        throw std::runtime_error("values and weights must be of equal length");
+
     int len;
     f_bin_grid_size(
         bin_grid.ptr.f_arg(),
         &len
     );
-    int data_size = values.size();
-    std::valarray<double> data(len);
+    std::valarray<double> data(0., len);
 
-    f_bin_grid_histogram_1d(
-        bin_grid.ptr.f_arg(),
-        begin(values),
-        begin(weights),
-        &data_size,
-        begin(data),
-        &len
+    const BinIndex index(bin_grid);
+    parallel_fill(values.size(), len, n_threads, begin(data),
+        [&](const size_t &first, const size_t &last, double *hist) {
+            for (size_t i = first; i < last; ++i) {
+                const int k = index(values[i]);
+                if (k >= 0)
+                    hist[k] += weights[i] / index.widths[k];
+            }
+        }
     );
-
     return data;
 }
 
-std::vector<std::vector<double>> histogram_2d(
+static void histogram_2d_into(
     const BinGrid &x_bin_grid,
-    std::valarray<double> x_values,
+    const tcb::span<const double> &x_values,
     const BinGrid &y_bin_grid,
-    std::valarray<double> y_values,
-    std::valarray<double> weights
+    const tcb::span<const double> &y_values,
+    const tcb::span<const double> &weights,
+    double *data,
+    const int &x_len,
+    const int &y_len,
+    const bool &accumulate,
+    const int &n_threads
 ) {
-    int x_len;
-    f_bin_grid_size(x_bin_grid.ptr.f_arg(), &x_len);
+    if (x_values.size() != weights.size() || y_values.size() != weights.size())
+        throw std::runtime_error("x_values, y_values and weights must be of equal length");
 
-    int y_len;
-    f_bin_grid_size(y_bin_grid.ptr.f_arg(), &y_len);
+    const BinIndex x_index(x_bin_grid), y_index(y_bin_grid);
+    if (!accumulate)
+        std::fill(data, data + x_len * y_len, 0.);
+    parallel_fill(x_values.size(), x_len * y_len, n_threads, data,
+        [&](const size_t &first, const size_t &last, double *hist) {
+            for (size_t i = first; i < last; ++i) {
+                const int kx = x_index(x_values[i]), ky = y_index(y_values[i]);
+                if (kx >= 0 && ky >= 0)
+                    hist[kx * y_len + ky] += weights[i]
+                        / (x_index.widths[kx] * y_index.widths[ky]);
+            }
+        }
+    );
+}
 
-    const int data_size = x_values.size();
+nb::object histogram_2d(
+    const BinGrid &x_bin_grid,
+    const tcb::span<const double> &x_values,
+    const BinGrid &y_bin_grid,
+    const tcb::span<const double> &y_values,
+    const tcb::span<const double> &weights,
+    const int &n_threads
+) {
+    const int x_len = BinGrid::__len__(x_bin_grid);
+    const int y_len = BinGrid::__len__(y_bin_grid);
+    std::valarray<double> data(x_len * y_len);
 
-    std::vector<std::vector<double>> data(
-        x_len,
-        std::vector<double>(y_len, 0)
-    );
-    std::valarray<double> data_flat(x_len * y_len);
-    f_bin_grid_histogram_2d(
-        x_bin_grid.ptr.f_arg(),
-        begin(x_values),
-        y_bin_grid.ptr.f_arg(),
-        begin(y_values),
-        begin(weights),
-        &data_size, 
-        begin(data_flat),
-        &x_len,
-        &y_len
+    histogram_2d_into(
+        x_bin_grid, x_values, y_bin_grid, y_values, weights,
+        begin(data), x_len, y_len, false, n_threads
     );
 
-    for(int i = 0; i < x_len; i++) {
-        for(int j = 0; j < y_len; j++) {
-            data[i][j] = data_flat[i*y_len + j];
-        }
-    }
+    return matrix_output(std::move(data), x_len, y_len);
+}
 
-    return data;
+void histogram_2d_accumulate(
+    const BinGrid &x_bin_grid,
+    const tcb::span<const double> &x_values,
+    const BinGrid &y_bin_grid,
+    const tcb::span<const double> &y_values,
+    const tcb::span<const double> &weights,
+    nb::ndarray<double, nb::ndim<2>, nb::c_contig, nb::device::cpu> out,
+    const int &n_threads
+) {
+    const int x_len = BinGrid::__len__(x_bin_grid);
+    const int y_len = BinGrid::__len__(y_bin_grid);
+    if ((int)out.shape(0) != x_len || (int)out.shape(1) != y_len)
+        throw std::runtime_error("out must be of shape (len(x_bin_grid), len(y_bin_grid))");
+
+    histogram_2d_into(
+        x_bin_grid, x_values, y_bin_grid, y_values, weights,
+        out.data(), x_len, y_len, true, n_threads
+    );
 }
@@ -7,9 +7,12 @@
 #pragma once
 
 #include "pmc_resource.hpp"
+#include <cmath>
 #include <valarray>
 #include <vector>
 #include "nanobind/stl/string.h"
+#include "tcb/span.hpp"
+#include "ndarray_output.hpp"
 
 extern "C" void f_bin_grid_ctor(void *ptr) noexcept;
 
@@ -28,6 +31,11 @@ extern "C" void f_bin_grid_size(
     int *val
 ) noexcept;
 
+extern "C" void f_bin_grid_type(
+    const void *ptr,
+    int *val
+) noexcept;
+
 extern "C" void f_bin_grid_edges(
     const void *ptr,
     void *arr_data,
@@ -46,31 +54,11 @@ extern "C" void f_bin_grid_widths(
     const int *arr_size
 ) noexcept;
 
-extern "C" void f_bin_grid_histogram_1d(
-    const void *x_bin_grid_ptr_c,
-    const void *x_data,
-    const void *weight_data,
-    const int *arr_size,
-    void *output_data,
-    const int *grid_size
-) noexcept;
-
-extern "C" void f_bin_grid_histogram_2d(
-    const void *x_bin_grid_ptr_c,
-    const void *x_data,
-    const void *y_bin_grid_ptr_c,
-    const void *y_data,
-    const void *weight_data,
-    const int *arr_size,
-    void *output_data,
-    const int *x_grid_size,
-    const int *y_grid_size
-) noexcept;
-
 namespace nb = nanobind;
 
 struct BinGrid {
     PMCResource ptr;
+    static constexpr int BIN_GRID_TYPE_LOG = 1, BIN_GRID_TYPE_LINEAR = 2;
 
     BinGrid(const int &n_bin, const nb::str &grid_type, const double &min, const double &max) :
         ptr(f_bin_grid_ctor, f_bin_grid_dtor)
@@ -78,8 +66,8 @@ struct BinGrid {
         const std::string grid_type_str {grid_type.c_str()}; 
 
         int type = 0;
-        if (grid_type_str == "log") type = 1;
-        if (grid_type_str == "linear") type = 2;
+        if (grid_type_str == "log") type = BIN_GRID_TYPE_LOG;
+        if (grid_type_str == "linear") type = BIN_GRID_TYPE_LINEAR;
         if (type == 0)
             throw std::invalid_argument( "Invalid grid spacing." );
 
@@ -100,6 +88,19 @@ struct BinGrid {
         return len;
     }
 
+    static int type(const BinGrid &self) {
+        int type;
+        f_bin_grid_type(
+            self.ptr.f_arg(),
+            &type
+        );
+        return type;
+    }
+
+    static std::string type_name(const BinGrid &self) {
+        return type(self) == BIN_GRID_TYPE_LOG ? "log" : "linear";
+    }
+
     static auto edges(const BinGrid &self)
     {
         int len;
@@ -154,16 +155,56 @@ struct BinGrid {
 
 };
 
+// closed-form bin lookup (grids are either log or linear) using the same arithmetic as
+// PartMC's bin_grid_find (values outside [edges[0], edges[n_bin]) are not binned)
+struct BinIndex {
+    bool log;
+    double min, range;
+    int n_bin;
+    std::valarray<double> widths;
+
+    explicit BinIndex(const BinGrid &bin_grid) :
+        log(BinGrid::type(bin_grid) == BinGrid::BIN_GRID_TYPE_LOG),
+        n_bin(BinGrid::__len__(bin_grid)),
+        widths(BinGrid::widths(bin_grid))
+    {
+        const auto edges = BinGrid::edges(bin_grid);
+        this->min = this->log ? std::log(edges[0]) : edges[0];
+        this->range = (this->log ? std::log(edges[n_bin]) : edges[n_bin]) - this->min;
+    }
+
+    // 0-based bin index, or -1 if the value is outside the grid (or NaN)
+    int operator()(const double &value) const {
+        const double pos = ((this->log ? std::log(value) : value) - this->min) / this->range * this->n_bin;
+        return (pos >= 0 && pos < this->n_bin) ? int(pos) : -1;
+    }
+};
+
+// n_threads: 0 for the number of hardware threads, data is split into contiguous chunks
+// histogrammed into per-thread partial histograms that are then summed
 std::valarray<double> histogram_1d(
     const BinGrid &bin_grid,
-    std::valarray<double> values,
-    std::valarray<double> weights
+    const tcb::span<const double> &values,
+    const tcb::span<const double> &weights,
+    const int &n_threads = 1
+);
+
+nb::object histogram_2d(
+    const BinGrid &x_bin_grid,
+    const tcb::span<const double> &x_values,
+    const BinGrid &y_bin_grid,
+    const tcb::span<const double> &y_values,
+    const tcb::span<const double> &weights,
+    const int &n_threads = 1
 );
 
-std::vector<std::vector<double>> histogram_2d(
+// adds the histogram to an existing (x_bins, y_bins) array in place
+void histogram_2d_accumulate(
     const BinGrid &x_bin_grid,
-    std::valarray<double> x_values,
+    const tcb::span<const double> &x_values,
     const BinGrid &y_bin_grid,
-    std::valarray<double> y_values,
-    std::valarray<double> weights
+    const tcb::span<const double> &y_values,
+    const tcb::span<const double> &weights,
+    nb::ndarray<double, nb::ndim<2>, nb::c_contig, nb::device::cpu> out,
+    const int &n_threads = 1
 );
@@ -0,0 +1,250 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#include <algorithm>
+#include "column_batch.hpp"
+
+ColumnBatch::ColumnBatch(const AeroState &aero_state, const tl::optional<double> &time) :
+    buffers(std::make_shared<Buffers>()),
+    length(AeroState::__len__(aero_state))
+{
+    const AeroData &aero_data = *aero_state.aero_data;
+    const int n_parts = this->length;
+    const int n_spec = AeroData::__len__(aero_data);
+    int n_source;
+    f_aero_data_n_source(aero_data.ptr.f_arg(), &n_source);
+    n_source = std::max(n_source, 0);
+
+    // reals: num_conc, least and greatest create time, n_spec volumes [, time]
+    const int n_reals = 3 + n_spec + time.has_value();
+    auto &buffers = *this->buffers;
+    buffers.ids.resize(n_parts);
+    buffers.reals.resize(n_reals * n_parts);
+    buffers.sources.resize(n_source * n_parts);
+    double *reals = std::begin(buffers.reals);
+    f_aero_state_columns(
+        aero_state.ptr.f_arg(),
+        aero_data.ptr.f_arg(),
+        std::begin(buffers.ids),
+        reals,
+        reals + n_parts,
+        reals + 2 * n_parts,
+        reals + 3 * n_parts,
+        std::begin(buffers.sources),
+        &n_spec,
+        &n_source,
+        &n_parts
+    );
+    if (time.has_value())
+        std::fill(reals + (n_reals - 1) * n_parts, reals + n_reals * n_parts, time.value());
+
+    this->columns.push_back({"id", "l", std::begin(buffers.ids)});
+    this->columns.push_back({"num_conc", "g", reals});
+    this->columns.push_back({"least_create_time", "g", reals + n_parts});
+    this->columns.push_back({"greatest_create_time", "g", reals + 2 * n_parts});
+    char name[AERO_NAME_LEN];
+    for (int i_spec = 0; i_spec < n_spec; ++i_spec) {
+        f_aero_data_spec_name_by_index(aero_data.ptr.f_arg(), &i_spec, name);
+        this->columns.push_back(
+            {"volume." + std::string(name), "g", reals + (3 + i_spec) * n_parts}
+        );
+    }
+    char source[AERO_SOURCE_NAME_LEN];
+    for (int i_source = 0; i_source < n_source; ++i_source) {
+        f_aero_data_source_name_by_index(aero_data.ptr.f_arg(), &i_source, source);
+        this->columns.push_back(
+            {"source." + std::string(source), "i", std::begin(buffers.sources) + i_source * n_parts}
+        );
+    }
+    if (time.has_value())
+        this->columns.push_back({"time", "g", reals + (n_reals - 1) * n_parts});
+}
+
+std::vector<std::string> ColumnBatch::names(const ColumnBatch &self) {
+    std::vector<std::string> names;
+    for (const auto &column : self.columns)
+        names.push_back(column.name);
+    return names;
+}
+
+nanobind::dict ColumnBatch::to_columns(const ColumnBatch &self) {
+    // the capsule keeps the buffers alive for as long as any of the arrays
+    auto *buffers = new std::shared_ptr<Buffers>(self.buffers);
+    nanobind::capsule owner(buffers, [](void *ptr) noexcept {
+        delete static_cast<std::shared_ptr<Buffers>*>(ptr);
+    });
+
+    nanobind::dict columns;
+    for (const auto &column : self.columns) {
+        void *data = const_cast<void*>(column.data);
+        if (list_output()) {
+            nanobind::list values;
+            for (std::size_t i = 0; i < self.length; ++i)
+                if (column.format == "l")
+                    values.append(static_cast<int64_t*>(data)[i]);
+                else if (column.format == "i")
+                    values.append(static_cast<int*>(data)[i]);
+                else
+                    values.append(static_cast<double*>(data)[i]);
+            columns[column.name.c_str()] = values;
+        }
+        else if (column.format == "l")
+            columns[column.name.c_str()] = ndarray_view(
+                static_cast<int64_t*>(data), {self.length}, owner
+            );
+        else if (column.format == "i")
+            columns[column.name.c_str()] = ndarray_view(
+                static_cast<int*>(data), {self.length}, owner
+            );
+        else
+            columns[column.name.c_str()] = ndarray_view(
+                static_cast<double*>(data), {self.length}, owner
+            );
+    }
+    return columns;
+}
+
+namespace {
+    // each child owns what it refers to, as consumers may move children out of their parent
+    struct ChildSchema {
+        std::string format, name;
+    };
+
+    struct ParentSchema {
+        std::vector<ArrowSchema> children;
+        std::vector<ArrowSchema*> child_ptrs;
+    };
+
+    struct ChildArray {
+        std::shared_ptr<ColumnBatch::Buffers> buffers;
+        const void *data[2];
+    };
+
+    struct ParentArray {
+        const void *validity[1] = {nullptr};
+        std::vector<ArrowArray> children;
+        std::vector<ArrowArray*> child_ptrs;
+    };
+
+    void release_child_schema(ArrowSchema *schema) {
+        delete static_cast<ChildSchema*>(schema->private_data);
+        schema->release = nullptr;
+    }
+
+    void release_parent_schema(ArrowSchema *schema) {
+        auto *parent = static_cast<ParentSchema*>(schema->private_data);
+        for (auto &child : parent->children)
+            if (child.release != nullptr)
+                child.release(&child);
+        delete parent;
+        schema->release = nullptr;
+    }
+
+    void release_child_array(ArrowArray *array) {
+        delete static_cast<ChildArray*>(array->private_data);
+        array->release = nullptr;
+    }
+
+    void release_parent_array(ArrowArray *array) {
+        auto *parent = static_cast<ParentArray*>(array->private_data);
+        for (auto &child : parent->children)
+            if (child.release != nullptr)
+                child.release(&child);
+        delete parent;
+        array->release = nullptr;
+    }
+
+    ArrowSchema *export_schema(const ColumnBatch &batch) {
+        auto *parent = new ParentSchema();
+        parent->children.resize(batch.columns.size());
+        for (std::size_t i = 0; i < batch.columns.size(); ++i) {
+            auto *child = new ChildSchema{batch.columns[i].format, batch.columns[i].name};
+            parent->children[i] = ArrowSchema{
+                child->format.c_str(), child->name.c_str(), nullptr, 0, 0, nullptr, nullptr,
+                release_child_schema, child
+            };
+            parent->child_ptrs.push_back(&parent->children[i]);
+        }
+        return new ArrowSchema{
+            "+s", "", nullptr, 0, static_cast<int64_t>(batch.columns.size()),
+            parent->child_ptrs.data(), nullptr, release_parent_schema, parent
+        };
+    }
+
+    ArrowArray *export_array(const ColumnBatch &batch) {
+        const auto length = static_cast<int64_t>(batch.length);
+        auto *parent = new ParentArray();
+        parent->children.resize(batch.columns.size());
+        for (std::size_t i = 0; i < batch.columns.size(); ++i) {
+            auto *child = new ChildArray{batch.buffers, {nullptr, batch.columns[i].data}};
+            parent->children[i] = ArrowArray{
+                length, 0, 0, 2, 0, child->data, nullptr, nullptr, release_child_array, child
+            };
+            parent->child_ptrs.push_back(&parent->children[i]);
+        }
+        return new ArrowArray{
+            length, 0, 0, 1, static_cast<int64_t>(batch.columns.size()), parent->validity,
+            parent->child_ptrs.data(), nullptr, release_parent_array, parent
+        };
+    }
+
+    nanobind::capsule schema_capsule(ArrowSchema *schema) {
+        return nanobind::capsule(schema, "arrow_schema", [](void *ptr) noexcept {
+            auto *schema = static_cast<ArrowSchema*>(ptr);
+            if (schema->release != nullptr)
+                schema->release(schema);
+            delete schema;
+        });
+    }
+
+    nanobind::capsule array_capsule(ArrowArray *array) {
+        return nanobind::capsule(array, "arrow_array", [](void *ptr) noexcept {
+            auto *array = static_cast<ArrowArray*>(ptr);
+            if (array->release != nullptr)
+                array->release(array);
+            delete array;
+        });
+    }
+}
+
+nanobind::object ColumnBatch::arrow_c_schema(const ColumnBatch &self) {
+    return schema_capsule(export_schema(self));
+}
+
+nanobind::tuple ColumnBatch::arrow_c_array(
+    const ColumnBatch &self,
+    const nanobind::object &requested_schema
+) {
+    // the schema is fixed, a requested one is not checked (as permitted by the protocol)
+    return nanobind::make_tuple(
+        schema_capsule(export_schema(self)),
+        array_capsule(export_array(self))
+    );
+}
+
+nanobind::object ColumnBatch::to_arrow(const ColumnBatch &self) {
+    return nanobind::module_::import_("pyarrow").attr("record_batch")(nanobind::cast(self));
+}
+
+void ArrowFileWriter::write(
+    ArrowFileWriter &self,
+    const AeroState &aero_state,
+    const tl::optional<double> &time
+) {
+    auto batch = ColumnBatch::to_arrow(ColumnBatch(aero_state, time));
+    if (!self.writer.is_valid())
+        self.writer = nanobind::module_::import_("pyarrow.ipc").attr("new_file")(
+            self.path, batch.attr("schema")
+        );
+    self.writer.attr("write_batch")(batch);
+}
+
+void ArrowFileWriter::close(ArrowFileWriter &self) {
+    if (self.writer.is_valid()) {
+        self.writer.attr("close")();
+        self.writer.reset();
+    }
+}
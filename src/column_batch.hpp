@@ -0,0 +1,103 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <valarray>
+#include <vector>
+#include "tl/optional.hpp"
+#include "aero_state.hpp"
+#include "ndarray_output.hpp"
+
+// Arrow C data interface (https://arrow.apache.org/docs/format/CDataInterface.html), the
+// structures are part of the specification and are meant to be copied, not linked against
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+struct ArrowSchema {
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+#endif
+
+// the particles of an AeroState as columns (id, num_conc, create times, per-species volumes,
+// per-source component counts and optionally the output time), each in a contiguous buffer
+// shared by the NumPy arrays of to_columns() and the Arrow arrays of __arrow_c_array__()
+struct ColumnBatch {
+    struct Buffers {
+        std::valarray<int64_t> ids;
+        std::valarray<double> reals;
+        std::valarray<int> sources;
+    };
+
+    struct Column {
+        std::string name;
+        std::string format;  // Arrow format string: "l" (int64), "g" (float64) or "i" (int32)
+        const void *data;
+    };
+
+    std::shared_ptr<Buffers> buffers;
+    std::size_t length;
+    std::vector<Column> columns;
+
+    ColumnBatch(const AeroState &aero_state, const tl::optional<double> &time);
+
+    static std::vector<std::string> names(const ColumnBatch &self);
+
+    static nanobind::dict to_columns(const ColumnBatch &self);
+
+    // PyCapsule interface of the Arrow C data interface, as used e.g. by pyarrow.record_batch()
+    static nanobind::tuple arrow_c_array(
+        const ColumnBatch &self,
+        const nanobind::object &requested_schema
+    );
+
+    static nanobind::object arrow_c_schema(const ColumnBatch &self);
+
+    static nanobind::object to_arrow(const ColumnBatch &self);
+};
+
+// appends AeroState snapshots as record batches to an Arrow IPC file (requires pyarrow)
+struct ArrowFileWriter {
+    std::string path;
+    nanobind::object writer;
+
+    ArrowFileWriter(const std::string &path) :
+        path(path)
+    {}
+
+    static void write(
+        ArrowFileWriter &self,
+        const AeroState &aero_state,
+        const tl::optional<double> &time
+    );
+
+    static void close(ArrowFileWriter &self);
+};
@@ -5,12 +5,14 @@
 ##################################################################################################*/
 
 #include "condense.hpp"
+#include "util.hpp"
 
 void condense_equilib_particle(
     const EnvState &env_state,
     const AeroData &aero_data,
     const AeroParticle &aero_particle
 ) {
+    auto lock = solver_lock();
     f_condense_equilib_particle(
         env_state.ptr.f_arg(),
         aero_data.ptr.f_arg(),
@@ -23,6 +25,7 @@ void condense_equilib_particles(
     const AeroData &aero_data,
     const AeroState &aero_state
 ) {
+    auto lock = solver_lock();
     f_condense_equilib_particles(
         env_state.ptr.f_arg(),
         aero_data.ptr.f_arg(),
@@ -24,6 +24,7 @@ extern "C" void f_env_state_get_pressure(const void *ptr, double *pressure) noex
 extern "C" void f_env_state_get_elapsed_time(const void *ptr, double *elapsed_time) noexcept;
 extern "C" void f_env_state_get_start_time(const void *ptr, double *start_time) noexcept;
 extern "C" void f_env_state_air_dens(const void *ptr, double *air_density) noexcept;
+extern "C" void f_env_state_copy(const void *ptr, void *ptr_to) noexcept;
 
 
 struct EnvState {
@@ -11,20 +11,21 @@
 #include "gas_data_parameters.hpp"
 #include "nanobind/nanobind.h"
 #include "nanobind_json/nanobind_json.hpp"
+#include "ndarray_output.hpp"
+#include "spec_index.hpp"
 
 extern "C" void f_gas_data_ctor(void *ptr) noexcept;
 extern "C" void f_gas_data_dtor(void *ptr) noexcept;
 extern "C" void f_gas_data_len(const void *ptr, int *len) noexcept;
 extern "C" void f_gas_data_from_json(const void *ptr) noexcept;
 extern "C" void f_gas_data_to_json(const void *ptr) noexcept;
-extern "C" void f_gas_data_spec_by_name(const void *ptr, int *value, const char *name_data,
-    const int *name_size) noexcept;
 extern "C" void f_gas_data_spec_name_by_index(const void *ptr, const int *i_spec,
     char *name_data) noexcept;
 
 struct GasData {
     PMCResource ptr;
     const nlohmann::json json;
+    LazySpecIndex spec_index_cache;
 
     GasData(const nanobind::tuple &tpl) :
         ptr(f_gas_data_ctor, f_gas_data_dtor),
@@ -59,18 +60,23 @@ struct GasData {
         return len;
     }
 
+    static const SpecIndex &spec_index(const GasData &self) {
+        return self.spec_index_cache.get([&]() {
+            char name[GAS_NAME_LEN];
+            return SpecIndex(__len__(self), [&](const int &idx) {
+                f_gas_data_spec_name_by_index(self.ptr.f_arg(), &idx, name);
+                return std::string(name);
+            });
+        });
+    }
+
     static auto spec_by_name(const GasData &self, const std::string &name) {
-        int value;
-        const int name_size = name.size();
-        f_gas_data_spec_by_name(
-            self.ptr.f_arg(),
-            &value,
-            name.c_str(),
-            &name_size
-        );
-        if (value == 0)
-            throw std::runtime_error("Element not found.");
-        return value - 1;
+        return spec_index(self).at(name);
+    }
+
+    static auto spec_indices(const GasData &self, const std::vector<std::string> &names) {
+        const auto indices = spec_index(self).at(names);
+        return valarray_output(std::valarray<int>(indices.data(), indices.size()));
     }
 
     static auto names(const GasData &self) {
@@ -10,6 +10,7 @@
 #include "json_resource.hpp"
 #include "pmc_resource.hpp"
 #include "gas_data.hpp"
+#include "nanobind/ndarray.h"
 
 extern "C" void f_gas_state_ctor(void *ptr) noexcept;
 extern "C" void f_gas_state_dtor(void *ptr) noexcept;
@@ -19,7 +20,9 @@ extern "C" void f_gas_state_len(const void *ptr, int *len) noexcept;
 extern "C" void f_gas_state_to_json(const void *ptr) noexcept;
 extern "C" void f_gas_state_from_json(const void *ptr, const void *gasdata_ptr) noexcept;
 extern "C" void f_gas_state_set_size(const void *ptr, const void *gasdata_ptr) noexcept;
-extern "C" void f_gas_state_mix_rats(const void *ptr, const double *data, const int *len);
+extern "C" void f_gas_state_get_mix_rats(const void *ptr, double *data, const int *len) noexcept;
+extern "C" void f_gas_state_set_mix_rats(const void *ptr, const double *data, const int *len) noexcept;
+extern "C" void f_gas_state_copy(const void *ptr, void *ptr_to) noexcept;
 
 struct GasState {
     PMCResource ptr;
@@ -76,18 +79,7 @@ struct GasState {
         const GasState &self,
         const std::string &name
     ) {
-        int value;
-        const int name_size = name.size();
-
-        f_gas_data_spec_by_name(
-            self.gas_data->ptr.f_arg(),
-            &value,
-            name.c_str(),
-            &name_size
-        );
-        if (value == 0)
-            throw std::runtime_error("Element not found.");
-        return get_item(self, value - 1);
+        return get_item(self, GasData::spec_by_name(*self.gas_data, name));
     }
 
     static void set_size(GasState &self) {
@@ -98,23 +90,32 @@ struct GasState {
     }
 
     static auto mix_rats(const GasState &self) {
-        int len;
-        f_gas_state_len(
+        const int len = __len__(self);
+        std::valarray<double> data(len);
+
+        f_gas_state_get_mix_rats(
             self.ptr.f_arg(),
+            begin(data),
             &len
         );
-        std::valarray<double> data(len);
-
-        for (int idx = 0; idx < len; idx++) {
-             f_gas_state_get_item(
-                 self.ptr.f_arg(),
-                 &idx,
-                 &data[idx]
-             );
-        }
         return data;
     }
 
+    static void set_mix_rats_array(
+        GasState &self,
+        const nanobind::ndarray<const double, nanobind::ndim<1>, nanobind::c_contig, nanobind::device::cpu> &data
+    ) {
+        const int len = __len__(self);
+        if ((int)data.shape(0) != len)
+            throw std::runtime_error("mixing ratios must be of length n_spec");
+
+        f_gas_state_set_mix_rats(
+            self.ptr.f_arg_non_const(),
+            data.data(),
+            &len
+        );
+    }
+
     static void set_mix_rats(const GasState &self, const nlohmann::json &json) {
         if (json.size() == 0)
             throw std::runtime_error("Non-empty sequence of mixing ratios expected");
@@ -6,14 +6,16 @@
 
 #include "json_resource.hpp"
 
+// each thread gets its own spec-file reader context so that objects can be
+// constructed concurrently (with the GIL released) from multiple threads
 template <class X>
-X& singleton()
+X& thread_local_singleton()
 {
-    static X x;
+    static thread_local X x;
     return x;
 }
 
 std::unique_ptr<JSONResource> &json_resource_ptr() {
-    return singleton<std::unique_ptr<JSONResource>>();
+    return thread_local_singleton<std::unique_ptr<JSONResource>>();
 }
 
@@ -0,0 +1,12 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#include "ndarray_output.hpp"
+
+bool &list_output() {
+    static bool flag = false;
+    return flag;
+}
@@ -0,0 +1,84 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#pragma once
+
+#include <valarray>
+#include <utility>
+#include <vector>
+#include "nanobind/nanobind.h"
+#include "nanobind/ndarray.h"
+
+bool &list_output();
+
+template <typename T>
+auto valarray_owner(std::valarray<T> &&data) {
+    // the returned capsule owns the buffer, NumPy arrays referring to it keep it alive
+    auto *buffer = new std::valarray<T>(std::move(data));
+    nanobind::capsule owner(buffer, [](void *ptr) noexcept {
+        delete static_cast<std::valarray<T>*>(ptr);
+    });
+    return std::make_pair(std::begin(*buffer), owner);
+}
+
+template <typename T>
+nanobind::object ndarray_view(
+    T *data,
+    std::initializer_list<size_t> shape,
+    nanobind::handle owner
+) {
+    return nanobind::cast(nanobind::ndarray<nanobind::numpy, T>(data, shape, owner));
+}
+
+template <typename T>
+nanobind::object valarray_output(std::valarray<T> &&data) {
+    if (list_output()) {
+        nanobind::list obj;
+        for (const auto &elem : data)
+            obj.append(elem);
+        return obj;
+    }
+
+    const size_t size = data.size();
+    auto buffer = valarray_owner(std::move(data));
+    return ndarray_view(buffer.first, {size}, buffer.second);
+}
+
+// row-major (rows, cols) data as a 2-D NumPy array, or as a list of rows with list_output()
+template <typename T>
+nanobind::object matrix_output(std::valarray<T> &&data, const size_t rows, const size_t cols) {
+    if (list_output()) {
+        nanobind::list obj;
+        for (size_t i = 0; i < rows; ++i)
+            obj.append(valarray_output(std::valarray<T>(data[std::slice(i * cols, cols, 1)])));
+        return obj;
+    }
+
+    auto buffer = valarray_owner(std::move(data));
+    return ndarray_view(buffer.first, {rows, cols}, buffer.second);
+}
+
+using ConstDoubleArray = nanobind::ndarray<const double, nanobind::c_contig, nanobind::device::cpu>;
+
+// applies an elementwise kernel over a whole buffer (a plain loop over contiguous memory
+// that the compiler can vectorise), the result is a NumPy array of the shape of the input
+template <typename Kernel>
+nanobind::object map_array(const ConstDoubleArray &x, Kernel kernel) {
+    const size_t size = x.size();
+    std::valarray<double> data(size);
+    const double *in = x.data();
+    double *out = std::begin(data);
+    for (size_t i = 0; i < size; ++i)
+        out[i] = kernel(in[i]);
+
+    std::vector<size_t> shape(x.ndim());
+    for (size_t i = 0; i < shape.size(); ++i)
+        shape[i] = x.shape(i);
+    auto buffer = valarray_owner(std::move(data));
+    return nanobind::cast(nanobind::ndarray<nanobind::numpy, double>(
+        buffer.first, shape.size(), shape.data(), buffer.second
+    ));
+}
@@ -4,35 +4,229 @@
 # Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
 ##################################################################################################*/
 
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
 #include "output.hpp"
 
+std::unique_lock<std::mutex> output_lock(const bool &do_output) {
+    static std::mutex mutex;
+    return do_output
+        ? std::unique_lock<std::mutex>(mutex)
+        : std::unique_lock<std::mutex>(mutex, std::defer_lock);
+}
+
+std::string output_filename(const std::string &prefix, const int &i_repeat, const int &index) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "_%04d_%08d.nc", i_repeat, index);
+    return prefix + suffix;
+}
+
+std::vector<std::string> output_filenames(const std::string &prefix, const int &i_repeat) {
+    const std::filesystem::path path(prefix);
+    const std::filesystem::path dir = path.has_parent_path() ? path.parent_path() : ".";
+    char repeat[8];
+    std::snprintf(repeat, sizeof(repeat), "_%04d_", i_repeat);
+    const std::string stem = path.filename().string() + repeat;
+    const std::string suffix = ".nc";
+    const std::size_t index_len = 8;
+
+    std::vector<std::pair<std::string, std::filesystem::path>> found;
+    if (std::filesystem::is_directory(dir)) {
+        for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+            const std::string name = entry.path().filename().string();
+            if (name.size() != stem.size() + index_len + suffix.size()
+                || name.compare(0, stem.size(), stem) != 0
+                || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+                continue;
+            const std::string index = name.substr(stem.size(), index_len);
+            if (!std::all_of(index.begin(), index.end(), [](char c) {
+                return c >= '0' && c <= '9';
+            }))
+                continue;
+            found.emplace_back(index, entry.path());
+        }
+    }
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> filenames;
+    for (const auto &file : found)
+        filenames.push_back(file.second.string());
+    return filenames;
+}
+
+void write_output_state(
+    const std::string &prefix,
+    const AeroData &aero_data,
+    const AeroState &aero_state,
+    const GasData &gas_data,
+    const GasState &gas_state,
+    const EnvState &env_state,
+    const OutputRecord &record,
+    const OutputLayout &layout
+) {
+    const int uuid_size = record.uuid.size();
+    if (!layout.any()) {
+        const int prefix_size = prefix.size();
+        f_output_state(prefix.c_str(), &prefix_size, aero_data.ptr.f_arg(),
+           aero_state.ptr.f_arg(), gas_data.ptr.f_arg(), gas_state.ptr.f_arg(),
+           env_state.ptr.f_arg(), &record.index, &record.time, &record.del_t,
+           &record.i_repeat, &record.record_removals, &record.record_optical,
+           record.uuid.c_str(), &uuid_size);
+        return;
+    }
+
+    const std::string filename = output_filename(prefix, record.i_repeat, record.index);
+    const int filename_size = filename.size();
+    int status;
+    f_output_state_layout(filename.c_str(), &filename_size, aero_data.ptr.f_arg(),
+       aero_state.ptr.f_arg(), gas_data.ptr.f_arg(), gas_state.ptr.f_arg(),
+       env_state.ptr.f_arg(), &record.index, &record.time, &record.del_t, &record.i_repeat,
+       &record.record_removals, &record.record_optical, record.uuid.c_str(), &uuid_size,
+       &layout.chunk_size, &layout.deflate_level, &layout.shuffle, &status);
+    if (status != 0)
+        throw std::runtime_error("writing " + filename + " with the output layout failed");
+}
+
 void output_state(
     const std::string &prefix,
     const AeroData &aero_data,
     const AeroState &aero_state,
     const GasData &gas_data,
     const GasState &gas_state,
-    const EnvState &env_state
+    const EnvState &env_state,
+    const OutputLayout &layout
 ){
-    int index;
-    double time;
-    double del_t;
-    int i_repeat;
-    bool record_removals;
-    bool record_optical;
-    const int prefix_size = prefix.size();
+    auto lock = output_lock();
+    write_output_state(prefix, aero_data, aero_state, gas_data, gas_state, env_state,
+        OutputRecord(), layout);
+}
+
+AsyncOutputWriter::AsyncOutputWriter(const std::size_t &max_pending) :
+    max_pending(max_pending)
+{
+    if (max_pending == 0)
+        throw std::runtime_error("max_pending must be positive");
+    this->thread = std::thread(&AsyncOutputWriter::run, this);
+}
+
+AsyncOutputWriter::~AsyncOutputWriter() {
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->cv.wait(lock, [this]() { return this->queue.empty() && !this->writing; });
+        this->stop = true;
+    }
+    this->cv.notify_all();
+    this->thread.join();
+
+    // a failure not reported by flush() or output_state() is not to go unnoticed
+    if (this->error) {
+        try {
+            std::rethrow_exception(this->error);
+        }
+        catch (const std::exception &exception) {
+            std::cerr << "WARN: AsyncOutputWriter: " << exception.what() << std::endl;
+        }
+        catch (...) {
+            std::cerr << "WARN: AsyncOutputWriter: output failed" << std::endl;
+        }
+    }
+}
 
-    index = 1;
-    time = 1.0;
-    del_t = 60.0;
-    i_repeat = 1;
-    record_removals = false;
-    record_optical = false;
+void AsyncOutputWriter::output_state(
+    AsyncOutputWriter &self,
+    const std::string &prefix,
+    const AeroData &aero_data,
+    const AeroState &aero_state,
+    const GasData &gas_data,
+    const GasState &gas_state,
+    const EnvState &env_state,
+    const int &index,
+    const OutputLayout &layout
+) {
+    // the copies refer to the AeroData and GasData of the states, which are to be the given
+    if (aero_state.aero_data.get() != &aero_data || gas_state.gas_data.get() != &gas_data)
+        throw std::runtime_error("aero_state and gas_state must use the given aero_data and gas_data");
+
+    OutputRecord record;
+    record.index = index;
+    enqueue(self, prefix, aero_state, gas_state, env_state, record, layout);
+}
+
+void AsyncOutputWriter::enqueue(
+    AsyncOutputWriter &self,
+    const std::string &prefix,
+    const AeroState &aero_state,
+    const GasState &gas_state,
+    const EnvState &env_state,
+    const OutputRecord &record,
+    const OutputLayout &layout
+) {
+    Job job;
+    job.prefix = prefix;
+    job.record = record;
+    job.layout = layout;
+    job.aero_data = aero_state.aero_data;
+    job.gas_data = gas_state.gas_data;
+    job.aero_state.reset(new AeroState(job.aero_data));
+    job.gas_state.reset(new GasState(job.gas_data));
+    job.env_state.reset(new EnvState());
+    f_aero_state_copy(aero_state.ptr.f_arg(), job.aero_state->ptr.f_arg_non_const());
+    f_gas_state_copy(gas_state.ptr.f_arg(), job.gas_state->ptr.f_arg_non_const());
+    f_env_state_copy(env_state.ptr.f_arg(), job.env_state->ptr.f_arg_non_const());
+
+    {
+        std::unique_lock<std::mutex> lock(self.mutex);
+        self.cv.wait(lock, [&self]() {
+            return self.queue.size() + self.writing < self.max_pending || self.error;
+        });
+        if (self.error) {
+            auto error = self.error;
+            self.error = nullptr;
+            std::rethrow_exception(error);
+        }
+        self.queue.push_back(std::move(job));
+    }
+    self.cv.notify_all();
+}
 
-    f_output_state(prefix.c_str(), &prefix_size, aero_data.ptr.f_arg(),
-       aero_state.ptr.f_arg(), gas_state.gas_data->ptr.f_arg(),
-       gas_state.ptr.f_arg(), env_state.ptr.f_arg(), &index, &time, &del_t,
-       &i_repeat, &record_removals, &record_optical);
+void AsyncOutputWriter::flush(AsyncOutputWriter &self) {
+    std::unique_lock<std::mutex> lock(self.mutex);
+    self.cv.wait(lock, [&self]() { return self.queue.empty() && !self.writing; });
+    if (self.error) {
+        auto error = self.error;
+        self.error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void AsyncOutputWriter::run() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->cv.wait(lock, [this]() { return this->stop || !this->queue.empty(); });
+        if (this->queue.empty())
+            return;
+        Job job = std::move(this->queue.front());
+        this->queue.pop_front();
+        this->writing = true;
+        lock.unlock();
+
+        try {
+            auto output = output_lock();
+            write_output_state(job.prefix, *job.aero_data, *job.aero_state, *job.gas_data,
+                *job.gas_state, *job.env_state, job.record, job.layout);
+        }
+        catch (...) {
+            lock.lock();
+            this->error = std::current_exception();
+            lock.unlock();
+        }
+        job = Job();
+
+        lock.lock();
+        this->writing = false;
+        this->cv.notify_all();
+    }
 }
 
 std::tuple<std::shared_ptr<AeroData>, AeroState*, std::shared_ptr<GasData>,
@@ -48,6 +242,7 @@ std::tuple<std::shared_ptr<AeroData>, AeroState*, std::shared_ptr<GasData>,
     AeroState *aero_state = new AeroState(std::shared_ptr<AeroData>(new AeroData()));
     GasState *gas_state = new GasState(std::shared_ptr<GasData>(new GasData()));
     EnvState *env_state = new EnvState();
+    auto lock = output_lock();
     f_input_state(name.c_str(), &name_size, &index, &time, &del_t, &i_repeat,
        aero_state->aero_data->ptr.f_arg_non_const(), aero_state->ptr.f_arg_non_const(),
        gas_state->gas_data->ptr.f_arg_non_const(), gas_state->ptr.f_arg_non_const(),
@@ -71,6 +266,7 @@ std::tuple<std::shared_ptr<AeroData>, BinGrid*, AeroBinned*, std::shared_ptr<Gas
     BinGrid *bin_grid = new BinGrid();
     GasState *gas_state = new GasState(std::shared_ptr<GasData>(new GasData()));
     EnvState *env_state = new EnvState();
+    auto lock = output_lock();
     f_input_sectional(name.c_str(), &name_size, &index, &time, &del_t, bin_grid->ptr.f_arg_non_const(),
        aero_binned->aero_data->ptr.f_arg_non_const(), aero_binned->ptr.f_arg_non_const(),
        gas_state->gas_data->ptr.f_arg_non_const(), gas_state->ptr.f_arg_non_const(),
@@ -93,6 +289,7 @@ std::tuple<std::shared_ptr<AeroData>, BinGrid*, AeroBinned*, std::shared_ptr<Gas
     BinGrid *bin_grid = new BinGrid();
     GasState *gas_state = new GasState(std::shared_ptr<GasData>(new GasData()));
     EnvState *env_state = new EnvState();
+    auto lock = output_lock();
     f_input_exact(name.c_str(), &name_size, &index, &time, &del_t, bin_grid->ptr.f_arg_non_const(),
        aero_binned->aero_data->ptr.f_arg_non_const(), aero_binned->ptr.f_arg_non_const(),
        gas_state->gas_data->ptr.f_arg_non_const(), gas_state->ptr.f_arg_non_const(),
@@ -101,3 +298,183 @@ std::tuple<std::shared_ptr<AeroData>, BinGrid*, AeroBinned*, std::shared_ptr<Gas
     return std::make_tuple(aero_binned->aero_data, bin_grid, aero_binned, gas_state->gas_data,
        gas_state, env_state);
 }
+
+OutputSeries::OutputSeries(
+    const std::string &prefix,
+    const int &i_repeat,
+    const tl::optional<std::vector<std::string>> &components
+) :
+    parts{true, true, true}
+{
+    static const std::vector<std::string> names = {"aero_state", "gas_state", "env_state"};
+    if (components.has_value()) {
+        std::fill(std::begin(this->parts), std::end(this->parts), false);
+        for (const auto &component : components.value()) {
+            auto it = std::find(names.begin(), names.end(), component);
+            if (it == names.end()) {
+                std::string err = "unknown component '" + component + "', valid options are: ";
+                for (auto name = names.begin(); name != names.end(); ++name)
+                    err += (name == names.begin() ? "" : ", ") + *name;
+                throw std::runtime_error(err);
+            }
+            this->parts[it - names.begin()] = true;
+        }
+    }
+
+    this->filenames = output_filenames(prefix, i_repeat);
+    if (this->filenames.empty())
+        throw std::runtime_error("no output files found for prefix '" + prefix + "'");
+}
+
+std::tuple<std::shared_ptr<AeroData>, AeroState*, std::shared_ptr<GasData>,
+     GasState*, EnvState*> OutputSeries::__getitem__(
+    OutputSeries &self,
+    const int &idx
+){
+    const int len = self.filenames.size();
+    if (idx < -len || idx >= len)
+        throw std::out_of_range("Index out of range");
+    const std::string &name = self.filenames[idx < 0 ? idx + len : idx];
+    const int name_size = name.size();
+
+    int index;
+    double time;
+    double del_t;
+    int i_repeat;
+    char uuid[64] = {0};
+    const int uuid_size = sizeof(uuid);
+    self.uuid.copy(uuid, uuid_size - 1);
+    bool reused;
+
+    auto aero_data = std::shared_ptr<AeroData>(new AeroData());
+    auto gas_data = std::shared_ptr<GasData>(new GasData());
+    std::unique_ptr<AeroState> aero_state;
+    std::unique_ptr<GasState> gas_state;
+    std::unique_ptr<EnvState> env_state;
+    const void *cached_aero_data = self.aero_data ? self.aero_data->ptr.f_arg() : nullptr;
+    const void *cached_gas_data = self.gas_data ? self.gas_data->ptr.f_arg() : nullptr;
+    {
+        auto lock = output_lock();
+        if (self.parts[0])
+            aero_state.reset(new AeroState(aero_data));
+        if (self.parts[1])
+            gas_state.reset(new GasState(gas_data));
+        if (self.parts[2])
+            env_state.reset(new EnvState());
+        f_input_state_parts(name.c_str(), &name_size, &index, &time, &del_t, &i_repeat,
+            uuid, &uuid_size, aero_data->ptr.f_arg_non_const(), cached_aero_data,
+            aero_state ? aero_state->ptr.f_arg_non_const() : nullptr,
+            gas_data->ptr.f_arg_non_const(), cached_gas_data,
+            gas_state ? gas_state->ptr.f_arg_non_const() : nullptr,
+            env_state ? env_state->ptr.f_arg_non_const() : nullptr,
+            self.parts, &reused);
+    }
+
+    if (reused) {
+        if (aero_state)
+            aero_state->aero_data = self.aero_data;
+        if (gas_state)
+            gas_state->gas_data = self.gas_data;
+    } else {
+        self.uuid = uuid;
+        self.aero_data = aero_data;
+        self.gas_data = gas_data;
+    }
+    return std::make_tuple(self.aero_data, aero_state.release(), self.gas_data,
+        gas_state.release(), env_state.release());
+}
+
+// a NetCDF file opened for reading, closed when going out of scope (also on exceptions)
+struct NcReadFile {
+    int ncid;
+
+    explicit NcReadFile(const std::string &filename) {
+        const int filename_size = filename.size();
+        f_nc_open_read(filename.c_str(), &filename_size, &this->ncid);
+    }
+
+    ~NcReadFile() {
+        f_nc_close(&this->ncid);
+    }
+};
+
+OutputFile::OutputFile(const std::string &filename) :
+    filename(filename)
+{
+    static const int max_ndims = 8;
+    int n_vars;
+
+    auto lock = output_lock();
+    const NcReadFile file(filename);
+    f_nc_n_vars(&file.ncid, &n_vars);
+    for (int i_var = 0; i_var < n_vars; ++i_var) {
+        char name[256];
+        const int name_size = sizeof(name);
+        int ndims, status;
+        int shape[max_ndims];
+        bool integer_type;
+        f_nc_var_info(&file.ncid, &i_var, name, &name_size, &ndims, shape, &max_ndims,
+            &integer_type, &status);
+        if (status != 0)
+            throw std::runtime_error("variable #" + std::to_string(i_var) + " of " + filename
+                + " has more than " + std::to_string(max_ndims) + " dimensions");
+
+        auto column = std::make_shared<OutputColumn>();
+        column->filename = filename;
+        column->name = name;
+        column->shape.assign(shape, shape + ndims);
+        column->integer_type = integer_type;
+        this->variables.push_back(column->name);
+        this->columns[column->name] = column;
+    }
+}
+
+std::shared_ptr<OutputColumn> OutputFile::__getitem__(
+    const OutputFile &self,
+    const std::string &name
+) {
+    auto it = self.columns.find(name);
+    if (it == self.columns.end())
+        throw std::runtime_error("unknown variable '" + name + "' in " + self.filename);
+    return it->second;
+}
+
+template <typename T, typename F>
+static nanobind::object read_column(const OutputColumn &column, const F &f_read) {
+    std::size_t size = 1;
+    for (const auto &dim : column.shape)
+        size *= dim;
+    std::valarray<T> data(size);
+
+    if (size > 0) {
+        const int name_size = column.name.size();
+        const int data_size = size;
+        int status;
+
+        nanobind::gil_scoped_release gil;
+        auto lock = output_lock();
+        {
+            const NcReadFile file(column.filename);
+            f_read(&file.ncid, column.name.c_str(), &name_size, std::begin(data),
+                &data_size, &status);
+        }
+        if (status == 1)
+            throw std::runtime_error("variable '" + column.name + "' of " + column.filename
+                + " changed its shape since the OutputFile was created");
+        if (status != 0)
+            throw std::runtime_error("cannot read variable '" + column.name + "' as numbers");
+    }
+
+    auto buffer = valarray_owner(std::move(data));
+    return nanobind::cast(nanobind::ndarray<nanobind::numpy, T>(
+        buffer.first, column.shape.size(), column.shape.data(), buffer.second
+    ));
+}
+
+nanobind::object OutputColumn::values(OutputColumn &self) {
+    if (!loaded(self))
+        self.data = self.integer_type
+            ? read_column<int64_t>(self, f_nc_read_var_int64)
+            : read_column<double>(self, f_nc_read_var);
+    return self.data;
+}
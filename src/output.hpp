@@ -6,6 +6,16 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tl/optional.hpp"
 #include "aero_state.hpp"
 #include "aero_binned.hpp"
 #include "aero_data.hpp"
@@ -14,6 +24,8 @@
 #include "env_state.hpp"
 #include "gas_data.hpp"
 #include "gas_state.hpp"
+#include "ndarray_output.hpp"
+#include "output_layout.hpp"
 
 extern "C" void f_output_state(
     const char *prefix,
@@ -28,7 +40,32 @@ extern "C" void f_output_state(
     const double *del_t,
     const int *i_repeat,
     const bool *record_removals,
-    const bool *record_optical
+    const bool *record_optical,
+    const char *uuid,
+    const int *uuid_size
+) noexcept;
+
+// as f_output_state() but to the given file with the layout, status is a NetCDF error code
+extern "C" void f_output_state_layout(
+    const char *filename,
+    const int *filename_size,
+    const void *aero_data,
+    const void *aero_state,
+    const void *gas_data,
+    const void *gas_state,
+    const void *env_state,
+    const int *index,
+    const double *time,
+    const double *del_t,
+    const int *i_repeat,
+    const bool *record_removals,
+    const bool *record_optical,
+    const char *uuid,
+    const int *uuid_size,
+    const int *chunk_size,
+    const int *deflate_level,
+    const bool *shuffle,
+    int *status
 ) noexcept;
 
 extern "C" void f_input_state(
@@ -73,15 +110,160 @@ extern "C" void f_input_exact(
     const void *env_state
 ) noexcept;
 
+extern "C" void f_input_state_parts(
+    const char *filename,
+    const int *filename_size,
+    int *index,
+    double *time,
+    double *del_t,
+    int *i_repeat,
+    char *uuid,
+    const int *uuid_size,
+    const void *aero_data,
+    const void *cached_aero_data,
+    const void *aero_state,
+    const void *gas_data,
+    const void *cached_gas_data,
+    const void *gas_state,
+    const void *env_state,
+    const bool *parts,
+    bool *reused
+) noexcept;
+
+extern "C" void f_nc_open_read(const char *filename, const int *filename_size, int *ncid) noexcept;
+extern "C" void f_nc_close(const int *ncid) noexcept;
+extern "C" void f_nc_n_vars(const int *ncid, int *n_vars) noexcept;
+extern "C" void f_nc_var_info(
+    const int *ncid,
+    const int *i_var,
+    char *name,
+    const int *name_size,
+    int *ndims,
+    int *shape,
+    const int *max_ndims,
+    bool *integer_type,
+    int *status
+) noexcept;
+extern "C" void f_nc_read_var(
+    const int *ncid,
+    const char *name,
+    const int *name_size,
+    double *data,
+    const int *data_size,
+    int *status
+) noexcept;
+extern "C" void f_nc_read_var_int64(
+    const int *ncid,
+    const char *name,
+    const int *name_size,
+    int64_t *data,
+    const int *data_size,
+    int *status
+) noexcept;
+
+// NetCDF and HDF5 are built without thread-safety, hence all file I/O (including the output
+// done from within run_part(), run_sect() and run_exact()) is serialised with a single lock
+std::unique_lock<std::mutex> output_lock(const bool &do_output = true);
+
+// name of the file written by PartMC for the given repeat and output index
+std::string output_filename(const std::string &prefix, const int &i_repeat, const int &index);
+
+// existing <prefix>_<repeat>_<index>.nc files of the given repeat, ordered by index
+std::vector<std::string> output_filenames(const std::string &prefix, const int &i_repeat);
+
+// the metadata written along with a state, the defaults are those of output_state() while
+// run_part*() fill in the output index and time and the run's options
+struct OutputRecord {
+    int index = 1;
+    double time = 1.0, del_t = 60.0;
+    int i_repeat = 1;
+    bool record_removals = false, record_optical = false;
+    std::string uuid;  // a new one for each file if empty
+};
+
+// writes <prefix>_<i_repeat>_<index>.nc, the caller holds output_lock()
+void write_output_state(
+    const std::string &prefix,
+    const AeroData &aero_data,
+    const AeroState &aero_state,
+    const GasData &gas_data,
+    const GasState &gas_state,
+    const EnvState &env_state,
+    const OutputRecord &record,
+    const OutputLayout &layout
+);
+
 void output_state(
     const std::string &prefix,
     const AeroData &aero_data,
     const AeroState &aero_state,
     const GasData &gas_data,
     const GasState &gas_state,
-    const EnvState &env_state
+    const EnvState &env_state,
+    const OutputLayout &layout = OutputLayout()
 );
 
+// output_state() done from a background thread: the states are copied into a bounded queue
+// (two pending writes by default, i.e. double-buffered) and written in order, so that the
+// simulation only blocks when the queue is full or on flush()
+struct AsyncOutputWriter {
+    struct Job {
+        std::string prefix;
+        OutputRecord record;
+        std::shared_ptr<AeroData> aero_data;
+        std::shared_ptr<GasData> gas_data;
+        std::unique_ptr<AeroState> aero_state;
+        std::unique_ptr<GasState> gas_state;
+        std::unique_ptr<EnvState> env_state;
+        OutputLayout layout;
+    };
+
+    std::size_t max_pending;
+    std::deque<Job> queue;
+    bool writing = false, stop = false;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+
+    AsyncOutputWriter(const std::size_t &max_pending);
+    ~AsyncOutputWriter();
+
+    static void output_state(
+        AsyncOutputWriter &self,
+        const std::string &prefix,
+        const AeroData &aero_data,
+        const AeroState &aero_state,
+        const GasData &gas_data,
+        const GasState &gas_state,
+        const EnvState &env_state,
+        const int &index,
+        const OutputLayout &layout
+    );
+
+    // queues a copy of the states (the AeroData and GasData are those of the states), used
+    // by run_part*() with RunPartOpt.async_writer set
+    static void enqueue(
+        AsyncOutputWriter &self,
+        const std::string &prefix,
+        const AeroState &aero_state,
+        const GasState &gas_state,
+        const EnvState &env_state,
+        const OutputRecord &record,
+        const OutputLayout &layout
+    );
+
+    // blocks until all queued states are written, rethrows a failure of the writer thread
+    static void flush(AsyncOutputWriter &self);
+
+    static std::size_t pending(AsyncOutputWriter &self) {
+        std::lock_guard<std::mutex> lock(self.mutex);
+        return self.queue.size() + self.writing;
+    }
+
+    void run();
+};
+
 std::tuple<std::shared_ptr<AeroData>, AeroState*, std::shared_ptr<GasData>, GasState*, EnvState*> input_state(
     const std::string &name
 );
@@ -94,3 +276,63 @@ std::tuple<std::shared_ptr<AeroData>, BinGrid*, AeroBinned*, std::shared_ptr<Gas
     EnvState*> input_exact(
     const std::string &name
 );
+
+// reads the files of one repeat of a run_part() output (<prefix>_<repeat>_<index>.nc) in
+// the order of their index, species metadata is read once and shared by all states of the
+// same run (identified by the UUID stored in the files), states not listed in components
+// are not read and come back as None
+struct OutputSeries {
+    std::vector<std::string> filenames;
+    bool parts[3];
+    std::string uuid;
+    std::shared_ptr<AeroData> aero_data;
+    std::shared_ptr<GasData> gas_data;
+
+    OutputSeries(
+        const std::string &prefix,
+        const int &i_repeat,
+        const tl::optional<std::vector<std::string>> &components
+    );
+
+    static std::size_t __len__(const OutputSeries &self) {
+        return self.filenames.size();
+    }
+
+    static std::tuple<std::shared_ptr<AeroData>, AeroState*, std::shared_ptr<GasData>,
+        GasState*, EnvState*> __getitem__(
+        OutputSeries &self,
+        const int &idx
+    );
+};
+
+// a variable of a NetCDF output file, its values are read (as doubles) on first access only
+// and kept for subsequent ones
+struct OutputColumn {
+    std::string filename;
+    std::string name;
+    std::vector<std::size_t> shape;
+    bool integer_type;  // read as int64 (e.g. particle IDs) rather than as doubles
+    nanobind::object data;
+
+    static bool loaded(const OutputColumn &self) {
+        return self.data.is_valid();
+    }
+
+    static nanobind::object values(OutputColumn &self);
+};
+
+// lists the variables of a NetCDF output file without reading any of their values, allowing
+// to read only the columns needed (e.g. aero_particle_mass and aero_num_conc) out of a file
+// that input_state() would read entirely
+struct OutputFile {
+    std::string filename;
+    std::vector<std::string> variables;
+    std::map<std::string, std::shared_ptr<OutputColumn>> columns;
+
+    OutputFile(const std::string &filename);
+
+    static std::shared_ptr<OutputColumn> __getitem__(
+        const OutputFile &self,
+        const std::string &name
+    );
+};
@@ -0,0 +1,36 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#pragma once
+
+#include <stdexcept>
+
+// storage of the NetCDF output: netCDF-4 chunks of about chunk_size values (0 for chunks of
+// whole variables), the HDF5 shuffle filter and deflate compression (level 1-9, 0 for none);
+// PartMC defines the variables itself, hence the state is written to an in-memory dataset
+// first and copied from there to the file with the layout
+struct OutputLayout {
+    int chunk_size = 0;
+    int deflate_level = 0;
+    bool shuffle = false;
+
+    OutputLayout() {}
+
+    OutputLayout(const int &chunk_size, const int &deflate_level, const bool &shuffle) :
+        chunk_size(chunk_size),
+        deflate_level(deflate_level),
+        shuffle(shuffle)
+    {
+        if (chunk_size < 0)
+            throw std::runtime_error("chunk_size must be non-negative");
+        if (deflate_level < 0 || deflate_level > 9)
+            throw std::runtime_error("deflate_level must be within [0, 9]");
+    }
+
+    bool any() const {
+        return chunk_size > 0 || deflate_level > 0 || shuffle;
+    }
+};
@@ -0,0 +1,64 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#include "nanobind/stl/shared_ptr.h"
+#include "output_sink.hpp"
+
+OutputSink::OutputSink(
+    const std::size_t &capacity,
+    const std::vector<std::string> &fields,
+    const nanobind::object &callback
+) :
+    capacity(capacity),
+    fields(fields),
+    callback(callback)
+{
+    if (capacity == 0)
+        throw std::runtime_error("capacity must be positive");
+    // validates the field names up front rather than at the first output time
+    AeroState::field_codes(AeroState::extract_field_codes(), fields, nullptr);
+}
+
+void OutputSink::take(
+    const OutputSink &self,
+    const int &index,
+    const AeroState &aero_state,
+    const GasState &gas_state,
+    const EnvState &env_state,
+    PendingSnapshots &pending
+) {
+    auto gas_mix_rats = GasState::mix_rats(gas_state);
+
+    nanobind::gil_scoped_acquire gil;
+    auto snapshot = std::make_shared<OutputSnapshot>();
+    snapshot->index = index;
+    snapshot->time = EnvState::get_elapsed_time(env_state);
+    snapshot->aero = AeroState::extract(aero_state, self.fields, tl::nullopt, tl::nullopt,
+        &env_state);
+    snapshot->mix_rats = valarray_output(std::move(gas_mix_rats));
+    snapshot->temperature = EnvState::temp(env_state);
+    snapshot->rel_humid = EnvState::rh(env_state);
+    snapshot->pressure = EnvState::get_pressure(env_state);
+    pending.push_back(std::move(snapshot));
+}
+
+void OutputSink::deliver(OutputSink &self, PendingSnapshots &pending) {
+    if (pending.empty())
+        return;
+
+    nanobind::gil_scoped_acquire gil;
+    PendingSnapshots snapshots;
+    snapshots.swap(pending);
+    for (const auto &snapshot : snapshots) {
+        if (self.callback.is_valid() && !self.callback.is_none()) {
+            self.callback(snapshot);
+            continue;
+        }
+        if (self.snapshots.size() == self.capacity)
+            self.snapshots.pop_front();
+        self.snapshots.push_back(snapshot);
+    }
+}
@@ -0,0 +1,83 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "aero_state.hpp"
+#include "env_state.hpp"
+#include "gas_state.hpp"
+#include "ndarray_output.hpp"
+
+// the state at an output time of run_part*() in columnar form: the particle columns
+// of AeroState.extract(), the gas mixing ratios and the environment
+struct OutputSnapshot {
+    int index;
+    double time;
+    nanobind::dict aero;
+    nanobind::object mix_rats;
+    double temperature, rel_humid, pressure;
+};
+
+// snapshots taken while run_part*() holds its locks, to be delivered once these are released
+// (any left, e.g. when unwinding, are dropped with the GIL held)
+struct PendingSnapshots : std::vector<std::shared_ptr<OutputSnapshot>> {
+    ~PendingSnapshots() {
+        if (!this->empty()) {
+            nanobind::gil_scoped_acquire gil;
+            this->clear();
+        }
+    }
+};
+
+// receives the output of run_part*() in memory instead of NetCDF files: without a callback
+// the last `capacity` snapshots are kept (a ring buffer), with a callback each snapshot is
+// passed to it and not kept
+struct OutputSink {
+    std::size_t capacity;
+    std::vector<std::string> fields;
+    nanobind::object callback;
+    std::deque<std::shared_ptr<OutputSnapshot>> snapshots;
+
+    OutputSink(
+        const std::size_t &capacity,
+        const std::vector<std::string> &fields,
+        const nanobind::object &callback
+    );
+
+    // called with the GIL released, from the thread running the simulation (holding its
+    // locks and random number generator state)
+    static void take(
+        const OutputSink &self,
+        const int &index,
+        const AeroState &aero_state,
+        const GasState &gas_state,
+        const EnvState &env_state,
+        PendingSnapshots &pending
+    );
+
+    // called with the GIL released, after the simulation has released its locks and
+    // generator state as the callback may run any Python code (including run_part*())
+    static void deliver(OutputSink &self, PendingSnapshots &pending);
+
+    static std::size_t __len__(const OutputSink &self) {
+        return self.snapshots.size();
+    }
+
+    static std::shared_ptr<OutputSnapshot> __getitem__(const OutputSink &self, const int &idx) {
+        const int len = self.snapshots.size();
+        if (idx < -len || idx >= len)
+            throw std::out_of_range("Index out of range");
+        return self.snapshots[idx < 0 ? idx + len : idx];
+    }
+
+    static void clear(OutputSink &self) {
+        self.snapshots.clear();
+    }
+};
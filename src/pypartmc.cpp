@@ -12,12 +12,15 @@
 #include "nanobind/stl/tuple.h"
 #include "nanobind/stl/detail/nb_optional.h"
 #include "nanobind/ndarray.h"
+#include <cstring>
+#include <type_traits>
 #undef snprintf // required to fix an issue with std::snprintf in nlohmann::json
 #include "nlohmann/json.hpp"
 #include "nanobind_json/nanobind_json.hpp"
 #include "sundials/sundials_config.h"
 #include "camp/version.h"
 #include "tl/optional.hpp"
+#include "tcb/span.hpp"
 
 #include "util.hpp"
 #include "rand.hpp"
@@ -32,6 +35,8 @@
 #include "aero_dist.hpp"
 #include "aero_mode.hpp"
 #include "aero_state.hpp"
+#include "aero_particle_view.hpp"
+#include "column_batch.hpp"
 #include "env_state.hpp"
 #include "gas_data.hpp"
 #include "gas_state.hpp"
@@ -40,7 +45,10 @@
 #include "camp_core.hpp"
 #include "photolysis.hpp"
 #include "output.hpp"
+#include "output_sink.hpp"
+#include "snapshot.hpp"
 #include "output_parameters.hpp"
+#include "ndarray_output.hpp"
 
 #define STRINGIFY(x) #x
 #define MACRO_STRINGIFY(x) STRINGIFY(x)
@@ -56,45 +64,80 @@ template <typename Type> struct type_caster<std::valarray<Type>> {
 
     using Caster = make_caster<Type>;
 
-    bool from_python(handle src, uint8_t flags, cleanup_list *cleanup) noexcept {
-        if (nb::isinstance<nb::list>(src)) {
-            try {
-                auto py_array = nb::cast<nb::list>(src);
-                size_t size = py_array.size();
+    using Array = nb::ndarray<nb::ro, nb::ndim<1>, nb::device::cpu>;
 
-                value.resize(size);
+    template <typename From>
+    void copy_strided(const Array &array) noexcept {
+        const auto *data = static_cast<const From*>(array.data());
+        const auto stride = array.stride(0);
+        for (size_t i = 0; i < value.size(); ++i)
+            value[i] = static_cast<Type>(data[static_cast<std::ptrdiff_t>(i) * stride]);
+    }
 
-                for (size_t i = 0; i < size; i++) {
-                    value[i] = nb::cast<Type>(py_array[i]);
-                }
+    bool from_ndarray(const Array &array) noexcept {
+        const size_t size = array.shape(0);
+        value.resize(size);
 
-                return true;
-            }
-            catch (...) {
-                PyErr_Clear();
-                return false;
-            }
+        if (array.dtype() == nb::dtype<Type>() && array.stride(0) == 1) {
+            if (size != 0)
+                std::memcpy(begin(value), array.data(), size * sizeof(Type));
+            return true;
         }
-        else if (nb::isinstance<nb::ndarray<Type, nb::ndim<1>>>(src)) {
-            try {
-                auto py_array = nb::cast<nb::ndarray<Type, nb::ndim<1>>>(src);
-                size_t size = py_array.size();
-                auto *data = py_array.data();
 
-                value.resize(size);
-
-                for (size_t i = 0; i < size; i++) {
-                    value[i] = data[i];
-                }
+        const auto code = array.dtype().code;
+        const auto bits = array.dtype().bits;
+        if (code == (uint8_t)dlpack::dtype_code::Float && std::is_floating_point<Type>::value) {
+            if (bits == 64) copy_strided<double>(array);
+            else if (bits == 32) copy_strided<float>(array);
+            else return false;
+        }
+        else if (code == (uint8_t)dlpack::dtype_code::Int) {
+            if (bits == 64) copy_strided<int64_t>(array);
+            else if (bits == 32) copy_strided<int32_t>(array);
+            else if (bits == 16) copy_strided<int16_t>(array);
+            else if (bits == 8) copy_strided<int8_t>(array);
+            else return false;
+        }
+        else if (code == (uint8_t)dlpack::dtype_code::UInt) {
+            if (bits == 64) copy_strided<uint64_t>(array);
+            else if (bits == 32) copy_strided<uint32_t>(array);
+            else if (bits == 16) copy_strided<uint16_t>(array);
+            else if (bits == 8) copy_strided<uint8_t>(array);
+            else return false;
+        }
+        else
+            return false;
+        return true;
+    }
 
-                return true;
-            }
-            catch (...) {
+    bool from_python(handle src, uint8_t flags, cleanup_list *cleanup) noexcept {
+        if (nb::isinstance<nb::list>(src) || nb::isinstance<nb::tuple>(src)) {
+            size_t size;
+            PyObject *temp;
+            PyObject **items = seq_get(src.ptr(), &size, &temp);
+            if (items == nullptr) {
                 PyErr_Clear();
                 return false;
             }
+
+            value.resize(size);
+            Caster caster;
+            bool success = true;
+            for (size_t i = 0; i < size; i++) {
+                if (!caster.from_python(items[i], flags | (uint8_t)cast_flags::convert, cleanup)) {
+                    success = false;
+                    break;
+                }
+                value[i] = caster.operator cast_t<Type>();
+            }
+            Py_XDECREF(temp);
+            return success;
         }
 
+        make_caster<Array> array_caster;
+        if (array_caster.from_python(src, flags & ~(uint8_t)cast_flags::convert, cleanup))
+            return from_ndarray(array_caster.value);
+
         return false;
     }
 
@@ -109,6 +152,29 @@ template <typename Type> struct type_caster<std::valarray<Type>> {
     }
 };
 
+template <typename Type> struct type_caster<tcb::span<const Type>> {
+    NB_TYPE_CASTER(tcb::span<const Type>, const_name("[") + const_name("tcb::span") + const_name("]"))
+
+    // the span refers either to the caller's buffer (C-contiguous array of matching dtype)
+    // or to a converted copy kept alive by the caster for the duration of the call
+    make_caster<nb::ndarray<const Type, nb::ndim<1>, nb::c_contig, nb::device::cpu>> array_caster;
+    make_caster<std::valarray<Type>> valarray_caster;
+
+    bool from_python(handle src, uint8_t flags, cleanup_list *cleanup) noexcept {
+        if (array_caster.from_python(src, flags & ~(uint8_t)cast_flags::convert, cleanup)) {
+            const auto &array = array_caster.value;
+            value = tcb::span<const Type>(array.data(), array.shape(0));
+            return true;
+        }
+        if (valarray_caster.from_python(src, flags, cleanup)) {
+            const auto &data = valarray_caster.value;
+            value = tcb::span<const Type>(begin(data), data.size());
+            return true;
+        }
+        return false;
+    }
+};
+
 template <typename Type> struct type_caster<tl::optional<Type>> : optional_caster<tl::optional<Type>> {};
 
 NAMESPACE_END(detail)
@@ -119,20 +185,37 @@ NB_MODULE(_PyPartMC, m) {
         PyPartMC is a Python interface to PartMC.
     )pbdoc";
 
-    m.def("run_part", &run_part, "Do a particle-resolved Monte Carlo simulation.");
-    m.def("run_part_timestep", &run_part_timestep, "Do a single time step");
-    m.def("run_part_timeblock", &run_part_timeblock, "Do a time block");
-    m.def("condense_equilib_particles", &condense_equilib_particles, R"pbdoc(
+    m.def("run_part", &run_part, nb::call_guard<nb::gil_scoped_release>(), "Do a particle-resolved Monte Carlo simulation.");
+    m.def("run_part_timestep", &run_part_timestep, nb::call_guard<nb::gil_scoped_release>(), "Do a single time step");
+    m.def("run_part_timeblock", &run_part_timeblock, nb::call_guard<nb::gil_scoped_release>(), "Do a time block");
+    m.def("run_part_ensemble", &run_part_ensemble, nb::call_guard<nb::gil_scoped_release>(),
+        R"pbdoc(
+          Run independent particle-resolved simulations (ensemble members sharing the scenario,
+          aero_data, gas_data and options) concurrently on a pool of n_threads threads (0 for
+          the number of hardware threads). Each member advances its own EnvState, AeroState and
+          GasState in place, uses its own random number stream and writes output (if enabled)
+          with its own repeat index. Members run serially if condensation, MOSAIC or CAMP are
+          enabled or if particles can be created (by coagulation, doubling, nucleation,
+          emissions or dilution, as the particle IDs come from a single counter), and file
+          output is serialised. Returns the per-member random seeds
+          (streams of the given seed, or of a random one if seed is 0, see RandomState),
+          members whose AeroState has a random_state use it instead and report a zero seed.
+        )pbdoc",
+        nb::arg("scenario"), nb::arg("env_states"), nb::arg("aero_data"), nb::arg("aero_states"),
+        nb::arg("gas_data"), nb::arg("gas_states"), nb::arg("run_part_opt"), nb::arg("camp_core"),
+        nb::arg("photolysis"), nb::arg("n_threads") = 0, nb::arg("seed") = 0
+    );
+    m.def("condense_equilib_particles", &condense_equilib_particles, nb::call_guard<nb::gil_scoped_release>(), R"pbdoc(
       Call condense_equilib_particle() on each particle in the aerosol
       to ensure that every particle has its water content in
       equilibrium.
     )pbdoc");
-    m.def("condense_equilib_particle", &condense_equilib_particle, R"pbdoc(
+    m.def("condense_equilib_particle", &condense_equilib_particle, nb::call_guard<nb::gil_scoped_release>(), R"pbdoc(
         Determine the water equilibrium state of a single particle.
     )pbdoc");
 
-    m.def("run_sect", &run_sect, "Do a 1D sectional simulation (Bott 1998 scheme).");
-    m.def("run_exact", &run_exact, "Do an exact solution simulation.");
+    m.def("run_sect", &run_sect, nb::call_guard<nb::gil_scoped_release>(), "Do a 1D sectional simulation (Bott 1998 scheme).");
+    m.def("run_exact", &run_exact, nb::call_guard<nb::gil_scoped_release>(), "Do an exact solution simulation.");
 
     nb::class_<AeroBinned>(m, "AeroBinned",
         R"pbdoc(
@@ -145,8 +228,12 @@ NB_MODULE(_PyPartMC, m) {
         .def(nb::init<std::shared_ptr<AeroData>, const BinGrid&>())
         .def_prop_ro("num_conc", AeroBinned::num_conc,
             "Returns the number concentration of each bin (#/m^3/log_width)")
-        .def_prop_ro("vol_conc", AeroBinned::vol_conc,
-            "Returns the volume concentration per bin per species (m^3/m^3/log_width)")
+        .def_prop_ro("vol_conc", [](const AeroBinned &self) { return AeroBinned::vol_conc(self); },
+            "Returns the volume concentration per bin per species (m^3/m^3/log_width)"
+            " as an (n_spec, n_bin) array")
+        .def_prop_ro("vol_conc_transposed", AeroBinned::vol_conc_transposed,
+            "Returns the volume concentration per bin per species (m^3/m^3/log_width)"
+            " as an (n_bin, n_spec) array")
         .def("add_aero_dist", AeroBinned::add_aero_dist,
             "Adds an AeroDist to an AeroBinned")
     ;
@@ -173,9 +260,11 @@ NB_MODULE(_PyPartMC, m) {
              same, but without the \c _a suffix.
         )pbdoc"
     )
-        .def(nb::init<const nlohmann::json&>())
+        .def(nb::init<const nlohmann::json&>(), nb::call_guard<nb::gil_scoped_release>())
         .def("spec_by_name", AeroData::spec_by_name,
              "Returns the number of the species in AeroData with the given name")
+        .def("spec_indices", AeroData::spec_indices,
+             "Returns the numbers of the species in AeroData with the given names")
         .def("__len__", AeroData::__len__, "Number of aerosol species")
         .def_prop_ro("n_source", AeroData::n_source,
              "Number of aerosol sources")
@@ -201,6 +290,14 @@ NB_MODULE(_PyPartMC, m) {
             "Convert geometric diameter (m) to mass-equivalent volume (m^3).")
         .def("vol2diam", AeroData::vol2diam,
             "Convert mass-equivalent volume (m^3) to geometric diameter (m).")
+        .def("rad2vol", AeroData::rad2vol_array, nb::arg("radii"),
+            "Convert an array of geometric radii (m) to mass-equivalent volumes (m^3).")
+        .def("vol2rad", AeroData::vol2rad_array, nb::arg("vols"),
+            "Convert an array of mass-equivalent volumes (m^3) to geometric radii (m).")
+        .def("diam2vol", AeroData::diam2vol_array, nb::arg("diams"),
+            "Convert an array of geometric diameters (m) to mass-equivalent volumes (m^3).")
+        .def("vol2diam", AeroData::vol2diam_array, nb::arg("vols"),
+            "Convert an array of mass-equivalent volumes (m^3) to geometric diameters (m).")
         .def_prop_ro("species", AeroData::names,
             "returns list of aerosol species names")
     ;
@@ -283,6 +380,85 @@ NB_MODULE(_PyPartMC, m) {
             "Sets the aerosol particle volumes.")
     ;
 
+    nb::class_<AeroParticleView>(m, "AeroParticleView",
+        R"pbdoc(
+             Reference to a particle stored in an AeroState (no copy is made).
+             The view is invalidated by any change of the number or ordering
+             of particles in the AeroState (e.g., adding, removing or sampling
+             particles, or running a simulation with it).
+        )pbdoc"
+    )
+        .def(nb::init<const AeroState&, const int&>(), nb::keep_alive<1, 2>())
+        .def_ro("index", &AeroParticleView::index,
+            "Index of the particle in the AeroState.")
+        .def_prop_ro("valid", AeroParticleView::valid,
+            "False if the AeroState has been changed in a way invalidating the view.")
+        .def_prop_ro("volumes", AeroParticleView::volumes,
+            "Constituent species volumes [m^3]")
+        .def_prop_ro("volume", AeroParticleView::volume,
+            "Total volume of the particle (m^3).")
+        .def_prop_ro("dry_volume", AeroParticleView::dry_volume,
+            "Total dry volume of the particle (m^3).")
+        .def_prop_ro("radius", AeroParticleView::radius,
+            "Total radius of the particle (m).")
+        .def_prop_ro("dry_radius", AeroParticleView::dry_radius,
+            "Total dry radius of the particle (m).")
+        .def_prop_ro("diameter", AeroParticleView::diameter,
+            "Total diameter of the particle (m).")
+        .def_prop_ro("dry_diameter", AeroParticleView::dry_diameter,
+            "Total dry diameter of the particle (m).")
+        .def_prop_ro("mass", AeroParticleView::mass,
+            "Total mass of the particle (kg).")
+        .def_prop_ro("density", AeroParticleView::density,
+            "Average density of the particle (kg/m^3)")
+        .def_prop_ro("id", AeroParticleView::id, "Unique ID number.")
+        .def("mobility_diameter", AeroParticleView::mobility_diameter,
+            "Mobility diameter of the particle (m).")
+        .def("crit_rel_humid", AeroParticleView::crit_rel_humid,
+            "Returns the critical relative humidity (1).")
+        .def("copy", AeroParticleView::copy,
+            "Returns a standalone AeroParticle copy of the referenced particle.")
+    ;
+
+    nb::class_<ColumnBatch>(m, "ColumnBatch",
+        R"pbdoc(
+          Particles of an AeroState as contiguous columns, shared without copying by the
+          NumPy arrays of to_columns() and by consumers of the Arrow PyCapsule interface
+          (e.g. pyarrow.record_batch(), polars.DataFrame()).
+        )pbdoc"
+    )
+        .def("__len__", [](const ColumnBatch &self) { return self.length; },
+            "returns the number of particles")
+        .def_prop_ro("names", ColumnBatch::names, "names of the columns")
+        .def("to_columns", ColumnBatch::to_columns,
+            "returns a dictionary of NumPy arrays, one for each column")
+        .def("to_arrow", ColumnBatch::to_arrow,
+            "returns a pyarrow.RecordBatch (requires pyarrow)")
+        .def("__arrow_c_schema__", ColumnBatch::arrow_c_schema)
+        .def("__arrow_c_array__", ColumnBatch::arrow_c_array,
+            nb::arg("requested_schema").none() = nb::none())
+    ;
+
+    nb::class_<ArrowFileWriter>(m, "ArrowFileWriter",
+        R"pbdoc(
+          Appends AeroState.to_arrow() record batches to an Arrow IPC file, the schema is
+          taken from the first batch written (requires pyarrow).
+        )pbdoc"
+    )
+        .def(nb::init<const std::string&>(), nb::arg("path"))
+        .def("write", ArrowFileWriter::write,
+            nb::arg("aero_state"), nb::arg("time").none() = nb::none(),
+            "appends the particles of aero_state as a record batch")
+        .def("close", ArrowFileWriter::close, "finishes the file")
+        .def("__enter__", [](ArrowFileWriter &self) -> ArrowFileWriter& { return self; },
+            nb::rv_policy::reference)
+        .def("__exit__",
+            [](ArrowFileWriter &self, nb::handle, nb::handle, nb::handle) {
+                ArrowFileWriter::close(self);
+            },
+            nb::arg("exc_type").none(), nb::arg("exc_value").none(), nb::arg("traceback").none())
+    ;
+
     nb::class_<AeroState>(m, "AeroState",
         R"pbdoc(
              The current collection of aerosol particles.
@@ -322,10 +498,52 @@ NB_MODULE(_PyPartMC, m) {
             nb::arg("include") = nb::none(), nb::arg("exclude") = nb::none())
         .def("crit_rel_humids", AeroState::crit_rel_humids,
             "returns the critical relative humidity of each particle in the population")
+        .def("extract", AeroState::extract,
+            "returns a dictionary of per-particle arrays, one for each of the requested fields"
+            " (num_concs, masses, volumes, diameters, dry_diameters, mobility_diameters,"
+            " crit_rel_humids, kappas, ids), computed in a single pass over the population;"
+            " include/exclude apply to masses, volumes and diameters, env_state is required"
+            " for mobility_diameters and crit_rel_humids",
+            nb::arg("fields"), nb::arg("include") = nb::none(), nb::arg("exclude") = nb::none(),
+            nb::arg("env_state").none() = nb::none())
+        .def("histogram", AeroState::histogram,
+            "returns the 1D (or, if y and y_grid are given, 2D) distribution of the particles"
+            " over x (and y), one of mass, volume, diameter, dry_diameter, mobility_diameter,"
+            " crit_rel_humid or kappa, weighted with num_conc, mass_conc or volume_conc and"
+            " scaled by the bin sizes as in histogram_1d() and histogram_2d(), without"
+            " materialising the per-particle arrays; include/exclude apply as in extract()",
+            nb::arg("x"), nb::arg("x_grid"), nb::arg("y") = nb::none(),
+            nb::arg("y_grid").none() = nb::none(), nb::arg("weight") = "num_conc",
+            nb::arg("include") = nb::none(), nb::arg("exclude") = nb::none(),
+            nb::arg("env_state").none() = nb::none(), nb::arg("n_threads") = 1)
+        .def("species_volumes", AeroState::species_volumes,
+            "returns the (n_part, n_spec) array of per-particle constituent species volumes")
+        .def("set_species_volumes", AeroState::set_species_volumes,
+            "sets the constituent species volumes of all particles from an (n_part, n_spec) array",
+            nb::arg("volumes"))
         .def("make_dry", AeroState::make_dry,
             "Make all particles dry (water set to zero).")
         .def_prop_ro("ids", AeroState::ids,
             "returns the IDs of all particles.")
+        .def("column_batch",
+            [](const AeroState &self, const tl::optional<double> &time) {
+                return new ColumnBatch(self, time);
+            },
+            nb::arg("time").none() = nb::none(),
+            "returns the particles as a ColumnBatch (id, num_conc, create times, volume.<species>"
+            " and source.<source> columns, plus a constant time column if time is given)")
+        .def("to_columns",
+            [](const AeroState &self, const tl::optional<double> &time) {
+                return ColumnBatch::to_columns(ColumnBatch(self, time));
+            },
+            nb::arg("time").none() = nb::none(),
+            "returns the columns of column_batch() as a dictionary of NumPy arrays")
+        .def("to_arrow",
+            [](const AeroState &self, const tl::optional<double> &time) {
+                return ColumnBatch::to_arrow(ColumnBatch(self, time));
+            },
+            nb::arg("time").none() = nb::none(),
+            "returns the columns of column_batch() as a pyarrow.RecordBatch (requires pyarrow)")
         .def("mixing_state", AeroState::mixing_state,
             "returns the mixing state parameters (d_alpha, d_gamma, chi) of the population",
             nb::arg("include") = nb::none(), nb::arg("exclude") = nb::none(),
@@ -334,9 +552,14 @@ NB_MODULE(_PyPartMC, m) {
             "composition-averages population using BinGrid")
         .def("particle", AeroState::get_particle,
             "returns the particle of a given index")
+        .def("particle_view",
+            [](const AeroState &self, const int &idx) { return new AeroParticleView(self, idx); },
+            nb::keep_alive<0, 1>(),
+            "returns a view of the particle of a given index referring to the particle"
+            " in place, without copying it")
         .def("rand_particle", AeroState::get_random_particle,
             "returns a random particle from the population")
-        .def("dist_sample", AeroState::dist_sample,
+        .def("dist_sample", AeroState::dist_sample, nb::call_guard<nb::gil_scoped_release>(),
             "sample particles for AeroState from an AeroDist",
             nb::arg("AeroDist"), nb::arg("sample_prop") = 1.0, nb::arg("create_time") = 0.0,
             nb::arg("allow_doubling") = true, nb::arg("allow_halving") = true)
@@ -364,6 +587,14 @@ NB_MODULE(_PyPartMC, m) {
         .def("remove_particle", AeroState::remove_particle,
             "remove particle of a given index")
         .def("zero", AeroState::zero, "remove all particles from an AeroState")
+        .def_prop_rw("random_state",
+            [](const AeroState &self) { return std::atomic_load(&self.random_state); },
+            [](AeroState &self, std::shared_ptr<RandomState> random_state) {
+                std::atomic_store(&self.random_state, std::move(random_state));
+            },
+            nb::for_setter(nb::arg("random_state").none()),
+            "RandomState used by sampling and by run_part*() instead of the thread's generator"
+            " (None by default)")
     ;
 
     nb::class_<GasData>(m, "GasData",
@@ -385,6 +616,8 @@ NB_MODULE(_PyPartMC, m) {
             "returns a string with JSON representation of the object")
         .def("spec_by_name", GasData::spec_by_name,
             "returns the number of the species in gas with the given name")
+        .def("spec_indices", GasData::spec_indices,
+            "returns the numbers of the species in gas with the given names")
         .def_prop_ro("species", GasData::names, "returns list of gas species names")
     ;
 
@@ -398,7 +631,7 @@ NB_MODULE(_PyPartMC, m) {
             scenario_t.
         )pbdoc"
     )
-        .def(nb::init<const nlohmann::json&>())
+        .def(nb::init<const nlohmann::json&>(), nb::call_guard<nb::gil_scoped_release>())
         .def("set_temperature", EnvState::set_temperature,
             "sets the temperature of the environment state")
         .def_prop_ro("temp", EnvState::temp,
@@ -457,6 +690,8 @@ NB_MODULE(_PyPartMC, m) {
                 const AeroData&,
                 const nlohmann::json&
             >(),
+            // unlike the other JSON constructors, this one and those of AeroMode and AeroDist
+            // keep the GIL as they add sources to the (typically shared) AeroData
             "instantiates and initializes from a JSON object"
         )
         .def("__str__", Scenario::__str__,
@@ -511,22 +746,73 @@ NB_MODULE(_PyPartMC, m) {
             "returns the mixing ratio of a gas species")
         .def_prop_rw("mix_rats", &GasState::mix_rats, &GasState::set_mix_rats,
             "provides access (read of write) to the array of mixing ratios")
+        .def("set_mix_rats_array", &GasState::set_mix_rats_array, nb::arg("mix_rats"),
+            "sets all mixing ratios at once from an array ordered as in GasData")
     ;
 
     nb::class_<RunPartOpt>(m,
         "RunPartOpt",
         "Options controlling the execution of run_part()."
     )
-        .def(nb::init<const nlohmann::json&>())
+        .def(nb::init<const nlohmann::json&>(), nb::call_guard<nb::gil_scoped_release>())
         .def_prop_ro("t_max", RunPartOpt::t_max, "total simulation time")
         .def_prop_ro("del_t", RunPartOpt::del_t, "time step")
+        .def_prop_rw("output_sink",
+            [](const RunPartOpt &self) { return self.output_sink; },
+            [](RunPartOpt &self, std::shared_ptr<OutputSink> output_sink) {
+                self.output_sink = output_sink;
+            },
+            nb::for_setter(nb::arg("output_sink").none()),
+            "OutputSink receiving the output of run_part*() instead of NetCDF files (or None)"
+        )
+        .def_prop_rw("async_writer",
+            [](const RunPartOpt &self) { return self.async_writer; },
+            [](RunPartOpt &self, std::shared_ptr<AsyncOutputWriter> async_writer) {
+                self.async_writer = async_writer;
+            },
+            nb::for_setter(nb::arg("async_writer").none()),
+            "AsyncOutputWriter writing the NetCDF files of run_part*() from a background"
+            " thread, the simulation only waits when it has max_pending writes queued (or None)"
+        )
+    ;
+
+    nb::class_<OutputSnapshot>(m,
+        "OutputSnapshot",
+        "State at an output time of run_part*(), as delivered to an OutputSink."
+    )
+        .def_ro("index", &OutputSnapshot::index, "output index (1 for the initial state)")
+        .def_ro("time", &OutputSnapshot::time, "elapsed simulation time")
+        .def_ro("aero", &OutputSnapshot::aero, "particle columns, as from AeroState.extract()")
+        .def_ro("mix_rats", &OutputSnapshot::mix_rats, "gas mixing ratios")
+        .def_ro("temperature", &OutputSnapshot::temperature, "temperature")
+        .def_ro("rel_humid", &OutputSnapshot::rel_humid, "relative humidity")
+        .def_ro("pressure", &OutputSnapshot::pressure, "pressure")
+    ;
+
+    nb::class_<OutputSink>(m,
+        "OutputSink",
+        R"pbdoc(
+          Receives the output of run_part(), run_part_timestep() and run_part_timeblock()
+          in memory when set as RunPartOpt.output_sink: at each output time (per t_output)
+          an OutputSnapshot with the given particle fields is either passed to the callback,
+          or, without a callback, appended to a ring buffer keeping the last capacity ones.
+        )pbdoc"
+    )
+        .def(nb::init<const std::size_t&, const std::vector<std::string>&, const nb::object&>(),
+            nb::arg("capacity") = 128,
+            nb::arg("fields") = std::vector<std::string>{"num_concs", "masses", "diameters"},
+            nb::arg("callback") = nb::none()
+        )
+        .def("__len__", OutputSink::__len__)
+        .def("__getitem__", OutputSink::__getitem__)
+        .def("clear", OutputSink::clear, "Discards the kept snapshots.")
     ;
 
     nb::class_<RunSectOpt>(m,
         "RunSectOpt",
         "Options controlling the execution of run_sect()."
     )
-        .def(nb::init<const nlohmann::json&, EnvState&>())
+        .def(nb::init<const nlohmann::json&, EnvState&>(), nb::call_guard<nb::gil_scoped_release>())
         .def_prop_ro("t_max", RunSectOpt::t_max, "total simulation time")
         .def_prop_ro("del_t", RunSectOpt::del_t, "time step")
     ;
@@ -535,7 +821,7 @@ NB_MODULE(_PyPartMC, m) {
         "RunExactOpt",
         "Options controlling the execution of run_exact()."
     )
-        .def(nb::init<const nlohmann::json&, EnvState&>())
+        .def(nb::init<const nlohmann::json&, EnvState&>(), nb::call_guard<nb::gil_scoped_release>())
         .def_prop_ro("t_max", RunExactOpt::t_max, "total simulation time")
     ;
 
@@ -545,6 +831,7 @@ NB_MODULE(_PyPartMC, m) {
         .def_prop_ro("edges", BinGrid::edges, "Bin edges")
         .def_prop_ro("centers", BinGrid::centers, "Bin centers")
         .def_prop_ro("widths", BinGrid::widths, "Bin widths")
+        .def_prop_ro("type", BinGrid::type_name, "Bin spacing (\"log\" or \"linear\")")
     ;
 
     nb::class_<AeroMode>(m,"AeroMode")
@@ -586,11 +873,26 @@ NB_MODULE(_PyPartMC, m) {
     m.def(
         "histogram_1d", &histogram_1d, nb::rv_policy::copy,
         "Return a 1D histogram with of the given weighted data, scaled by the bin sizes."
+        " Log and linear grids are binned in closed form on n_threads threads (0 for the"
+        " number of hardware threads).",
+        nb::arg("bin_grid"), nb::arg("values"), nb::arg("weights"), nb::arg("n_threads") = 1
     );
 
     m.def(
         "histogram_2d", &histogram_2d, nb::rv_policy::copy,
         "Return a 2D histogram with of the given weighted data, scaled by the bin sizes."
+        " Log and linear grids are binned in closed form on n_threads threads (0 for the"
+        " number of hardware threads).",
+        nb::arg("x_bin_grid"), nb::arg("x_values"), nb::arg("y_bin_grid"), nb::arg("y_values"),
+        nb::arg("weights"), nb::arg("n_threads") = 1
+    );
+
+    m.def(
+        "histogram_2d_accumulate", &histogram_2d_accumulate,
+        "Add a 2D histogram of the given weighted data, scaled by the bin sizes, to an existing"
+        " (len(x_bin_grid), len(y_bin_grid)) float64 array in place.",
+        nb::arg("x_bin_grid"), nb::arg("x_values"), nb::arg("y_bin_grid"), nb::arg("y_values"),
+        nb::arg("weights"), nb::arg("out").noconvert(), nb::arg("n_threads") = 1
     );
 
     //  TODO #120: auto util = m.def_submodule("util", "...");
@@ -604,21 +906,41 @@ NB_MODULE(_PyPartMC, m) {
         "Convert mass-equivalent volume (m^3) to geometric radius (m) for spherical particles."
     );
 
+    m.def(
+        "sphere_vol2rad", &sphere_vol2rad_array, nb::arg("values"),
+        "Convert an array of mass-equivalent volumes (m^3) to geometric radii (m) for spherical particles (elementwise, the result has the shape of the input)."
+    );
+
     m.def(
         "rad2diam", &rad2diam, nb::rv_policy::copy,
         "Convert radius (m) to diameter (m)."
     );
 
+    m.def(
+        "rad2diam", &rad2diam_array, nb::arg("values"),
+        "Convert an array of radii (m) to diameters (m) (elementwise, the result has the shape of the input)."
+    );
+
     m.def(
         "sphere_rad2vol", &sphere_rad2vol, nb::rv_policy::copy,
         "Convert geometric radius (m) to mass-equivalent volume for spherical particles."
     );
 
+    m.def(
+        "sphere_rad2vol", &sphere_rad2vol_array, nb::arg("values"),
+        "Convert an array of geometric radii (m) to mass-equivalent volumes for spherical particles (elementwise, the result has the shape of the input)."
+    );
+
     m.def(
         "diam2rad", &diam2rad, nb::rv_policy::copy,
         "Convert diameter (m) to radius (m)."
     );
 
+    m.def(
+        "diam2rad", &diam2rad_array, nb::arg("values"),
+        "Convert an array of diameters (m) to radii (m) (elementwise, the result has the shape of the input)."
+    );
+
     m.def(
         "loss_rate_dry_dep", &loss_rate_dry_dep, nb::rv_policy::copy,
         "Compute and return the dry deposition rate for a given particle."
@@ -630,7 +952,114 @@ NB_MODULE(_PyPartMC, m) {
     );
 
     m.def(
-        "output_state", &output_state, "Output current state to netCDF file."
+        "output_state",
+        [](
+            const std::string &prefix, const AeroData &aero_data, const AeroState &aero_state,
+            const GasData &gas_data, const GasState &gas_state, const EnvState &env_state,
+            const int &chunk_size, const int &deflate_level, const bool &shuffle
+        ) {
+            output_state(prefix, aero_data, aero_state, gas_data, gas_state, env_state,
+                OutputLayout(chunk_size, deflate_level, shuffle));
+        },
+        nb::arg("prefix"), nb::arg("aero_data"), nb::arg("aero_state"), nb::arg("gas_data"),
+        nb::arg("gas_state"), nb::arg("env_state"), nb::arg("chunk_size") = 0,
+        nb::arg("deflate_level") = 0, nb::arg("shuffle") = false,
+        R"pbdoc(
+          Output current state to netCDF file. Optionally, the file is stored in
+          netCDF-4 chunks of about chunk_size values, with the shuffle filter and with
+          deflate compression of the given level (1-9).
+        )pbdoc"
+    );
+
+    nb::class_<AsyncOutputWriter>(m, "AsyncOutputWriter",
+        R"pbdoc(
+          Writes output_state() files from a background thread. The states are copied
+          when queued, so they can be advanced right after output_state() returns, which
+          only blocks while max_pending writes are outstanding. Set as
+          RunPartOpt.async_writer, it writes the output files of run_part*().
+        )pbdoc"
+    )
+        .def(nb::init<const std::size_t&>(), nb::arg("max_pending") = 2)
+        .def("output_state",
+            [](
+                AsyncOutputWriter &self, const std::string &prefix, const AeroData &aero_data,
+                const AeroState &aero_state, const GasData &gas_data,
+                const GasState &gas_state, const EnvState &env_state, const int &index,
+                const int &chunk_size, const int &deflate_level, const bool &shuffle
+            ) {
+                AsyncOutputWriter::output_state(self, prefix, aero_data, aero_state, gas_data,
+                    gas_state, env_state, index, OutputLayout(chunk_size, deflate_level, shuffle));
+            },
+            nb::call_guard<nb::gil_scoped_release>(),
+            nb::arg("prefix"), nb::arg("aero_data"), nb::arg("aero_state"), nb::arg("gas_data"),
+            nb::arg("gas_state"), nb::arg("env_state"), nb::arg("index") = 1,
+            nb::arg("chunk_size") = 0, nb::arg("deflate_level") = 0, nb::arg("shuffle") = false,
+            R"pbdoc(
+              Queues the output of the current state to the netCDF file of the given
+              index, the storage options are as for output_state().
+            )pbdoc"
+        )
+        .def("flush", AsyncOutputWriter::flush, nb::call_guard<nb::gil_scoped_release>(),
+            "Waits until all queued states are written.")
+        .def_prop_ro("pending", AsyncOutputWriter::pending,
+            "Number of queued states not written yet.")
+    ;
+
+    nb::class_<StateSnapshot>(m, "StateSnapshot",
+        R"pbdoc(
+          In-memory copy of an (AeroState, GasState, EnvState) triple held in a single
+          contiguous buffer, e.g. for branching a simulation or for checkpointing. The
+          AeroData and GasData are shared with the states, not copied; pickling includes
+          them so that snapshots can be sent to other processes.
+        )pbdoc"
+    )
+        .def(nb::init<const AeroState&, const GasState&, const EnvState&>(),
+            nb::arg("aero_state"), nb::arg("gas_state"), nb::arg("env_state"))
+        .def("restore", StateSnapshot::restore,
+            "returns a new (AeroState, GasState, EnvState) triple with the snapshotted state,"
+            " sharing the AeroData and GasData of the snapshot")
+        .def_prop_ro("data",
+            [](const StateSnapshot &self) {
+                return nb::bytes(self.data.data(), self.data.size());
+            },
+            "the serialised states (without the species metadata)")
+        .def_ro("aero_data", &StateSnapshot::aero_data)
+        .def_ro("gas_data", &StateSnapshot::gas_data)
+        .def("__len__", StateSnapshot::__len__, "size of the buffer in bytes")
+        .def("__getstate__",
+            [](const StateSnapshot &self) {
+                const auto metadata = StateSnapshot::metadata(self);
+                return nb::make_tuple(
+                    nb::bytes(self.data.data(), self.data.size()),
+                    nb::bytes(metadata.data(), metadata.size()),
+                    self.allow_halving,
+                    self.allow_doubling
+                );
+            })
+        .def("__setstate__",
+            [](StateSnapshot &self, const std::tuple<nb::bytes, nb::bytes, int, int> &state) {
+                const auto &data = std::get<0>(state), &metadata = std::get<1>(state);
+                new (&self) StateSnapshot(
+                    std::string(data.c_str(), data.size()),
+                    std::string(metadata.c_str(), metadata.size()),
+                    std::get<2>(state),
+                    std::get<3>(state)
+                );
+            })
+    ;
+
+    m.def(
+        "snapshot",
+        [](const AeroState &aero_state, const GasState &gas_state, const EnvState &env_state) {
+            return new StateSnapshot(aero_state, gas_state, env_state);
+        },
+        nb::arg("aero_state"), nb::arg("gas_state"), nb::arg("env_state"),
+        "Copies the (AeroState, GasState, EnvState) triple into a StateSnapshot."
+    );
+
+    m.def(
+        "restore", StateSnapshot::restore, nb::arg("snapshot"),
+        "Returns a new (AeroState, GasState, EnvState) triple from a StateSnapshot."
     );
 
     m.def(
@@ -645,14 +1074,103 @@ NB_MODULE(_PyPartMC, m) {
         "input_exact", &input_exact, "Read current state from run_exact netCDF output file."
     );
 
+    nb::class_<OutputColumn>(m, "OutputColumn",
+        "Variable of a NetCDF output file, read on first access of its values."
+    )
+        .def_ro("name", &OutputColumn::name, "Name of the NetCDF variable.")
+        .def_ro("shape", &OutputColumn::shape, "Shape of the variable (C order).")
+        .def_prop_ro("loaded", OutputColumn::loaded, "Whether the values have been read.")
+        .def_prop_ro("values", OutputColumn::values,
+            "Values of the variable as a NumPy array of doubles, or of 64-bit integers for"
+            " integer variables such as aero_id (read on first access).")
+    ;
+
+    nb::class_<OutputFile>(m, "OutputFile",
+        R"pbdoc(
+          Lists the variables of a NetCDF output file, and gives access to each of them
+          as an OutputColumn without reading the other ones.
+        )pbdoc"
+    )
+        .def(nb::init<const std::string&>(), nb::arg("filename"))
+        .def_ro("filename", &OutputFile::filename, "Name of the file.")
+        .def_ro("variables", &OutputFile::variables, "Names of the variables in the file.")
+        .def("__getitem__", OutputFile::__getitem__,
+            "Returns the column of the given variable.")
+    ;
+
+    nb::class_<OutputSeries>(m, "OutputSeries",
+        R"pbdoc(
+          Sequence of the states written by run_part() for one repeat, read from the
+          <prefix>_<repeat>_<index>.nc files in the order of their index. Species metadata
+          is read once per run and the same AeroData and GasData instances are shared by
+          all returned states. Only the states listed in components (any of "aero_state",
+          "gas_state", "env_state") are read, the others are returned as None.
+        )pbdoc"
+    )
+        .def(nb::init<const std::string&, const int&,
+            const tl::optional<std::vector<std::string>>&>(),
+            nb::arg("prefix"), nb::arg("i_repeat") = 1, nb::arg("components") = nb::none()
+        )
+        .def("__len__", OutputSeries::__len__)
+        .def("__getitem__", OutputSeries::__getitem__,
+            "Reads the given file, returns (aero_data, aero_state, gas_data, gas_state, env_state).")
+        .def_ro("filenames", &OutputSeries::filenames, "Names of the files in the series.")
+    ;
+
     m.def(
         "rand_init", &rand_init, "Initializes the random number generator to the state defined by the given seed. If the seed is 0 then a seed is auto-generated from the current time"
     );
 
+    nb::class_<RandomState>(m, "RandomState",
+        R"pbdoc(
+          Random number generator state owned by an object (see AeroState.random_state)
+          instead of by the calling thread. Streams of a given seed are independent and
+          each one is computed directly from its index. A zero seed picks a random one.
+        )pbdoc"
+    )
+        .def(nb::init<const int&, const int&>(), nb::arg("seed") = 0, nb::arg("stream") = 0)
+        .def_ro("seed", &RandomState::seed,
+            "seed of the stream, rand_init(seed) reproduces it on the calling thread")
+    ;
+
     m.def(
         "rand_normal", &rand_normal, "Generates a normally distributed random number with the given mean and standard deviation"
     );
 
+    m.def(
+        "rand_normal", &rand_normal_array,
+        "Generates an array of n normally distributed random numbers with the given mean and standard deviation",
+        nb::arg("mean"), nb::arg("stddev"), nb::arg("n"), nb::arg("random_state").none() = nb::none()
+    );
+
+    m.def(
+        "rand_uniform", &rand_uniform,
+        "Generates an array of n random numbers uniformly distributed in [0, 1)",
+        nb::arg("n"), nb::arg("random_state").none() = nb::none()
+    );
+
+    m.def(
+        "rand_poisson", &rand_poisson,
+        "Generates an array of n Poisson distributed random numbers with the given mean",
+        nb::arg("mean"), nb::arg("n"), nb::arg("random_state").none() = nb::none()
+    );
+
+    m.def(
+        "rand_binomial", &rand_binomial,
+        "Generates an array of size binomially distributed random numbers (n trials with probability p)",
+        nb::arg("n"), nb::arg("p"), nb::arg("size"), nb::arg("random_state").none() = nb::none()
+    );
+
+    m.def(
+        "set_list_output", [](const bool value) { list_output() = value; },
+        "If set to True, per-particle AeroState quantities are returned as lists instead of NumPy arrays (backward-compatible behaviour)"
+    );
+
+    m.def(
+        "list_output", []() { return list_output(); },
+        "Returns True if per-particle AeroState quantities are returned as lists instead of NumPy arrays"
+    );
+
     auto vobtd = nb::dict();
     vobtd["nanobind"] = MACRO_STRINGIFY(NB_VERSION_MAJOR) "." MACRO_STRINGIFY(NB_VERSION_MINOR) "." MACRO_STRINGIFY(NB_VERSION_PATCH);
     vobtd["PartMC"] = PARTMC_VERSION;
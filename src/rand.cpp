@@ -4,7 +4,11 @@
 # Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
 ##################################################################################################*/
 
+#include <random>
+#include <utility>
+#include <stdexcept>
 #include "rand.hpp"
+#include "ndarray_output.hpp"
 
 void rand_init(int seed) {
   f_pmc_srand(&seed);
@@ -17,3 +21,109 @@ double rand_normal(double mean, double stddev) {
 
   return val;
 }
+
+int stream_seed(const uint64_t &seed, const uint64_t &stream) {
+  const uint64_t base = seed != 0 ? seed : std::random_device()();
+  uint64_t z = base + (stream + 1) * 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return 1 + int((z ^ (z >> 31)) % 0x7FFFFFFEull);
+}
+
+std::vector<int> RandomState::thread_state() {
+  int n;
+  f_rand_state_size(&n);
+  std::vector<int> state(n);
+  f_rand_state_get(state.data(), &n);
+  return state;
+}
+
+void RandomState::set_thread_state(const std::vector<int> &state) {
+  const int n = state.size();
+  f_rand_state_put(state.data(), &n);
+}
+
+RandomState::RandomState(const int &seed, const int &stream) :
+  seed(stream_seed(seed, stream))
+{
+  if (stream < 0)
+    throw std::runtime_error("stream must be non-negative");
+
+  const auto saved = thread_state();
+  rand_init(this->seed);
+  this->state = thread_state();
+  set_thread_state(saved);
+}
+
+RandomStateGuard::RandomStateGuard(std::shared_ptr<RandomState> random_state) :
+  random_state(std::move(random_state))
+{
+  if (this->random_state == nullptr)
+    return;
+  this->saved = RandomState::thread_state();
+  RandomState::set_thread_state(this->random_state->state);
+}
+
+RandomStateGuard::~RandomStateGuard() {
+  if (this->random_state == nullptr)
+    return;
+  this->random_state->state = RandomState::thread_state();
+  RandomState::set_thread_state(this->saved);
+}
+
+static void check_size(const int &n) {
+  if (n < 0)
+    throw std::runtime_error("size must be non-negative");
+}
+
+nanobind::object rand_normal_array(
+  const double &mean, const double &stddev, const int &n, std::shared_ptr<RandomState> random_state
+) {
+  check_size(n);
+  std::valarray<double> vals(n);
+  {
+    RandomStateGuard guard(random_state);
+    f_rand_normal_array(&mean, &stddev, begin(vals), &n);
+  }
+  return valarray_output(std::move(vals));
+}
+
+nanobind::object rand_uniform(const int &n, std::shared_ptr<RandomState> random_state) {
+  check_size(n);
+  std::valarray<double> vals(n);
+  {
+    RandomStateGuard guard(random_state);
+    f_rand_uniform_array(begin(vals), &n);
+  }
+  return valarray_output(std::move(vals));
+}
+
+nanobind::object rand_poisson(
+  const double &mean, const int &n, std::shared_ptr<RandomState> random_state
+) {
+  check_size(n);
+  if (mean < 0)
+    throw std::runtime_error("mean must be non-negative");
+  std::valarray<int> vals(n);
+  {
+    RandomStateGuard guard(random_state);
+    f_rand_poisson_array(&mean, begin(vals), &n);
+  }
+  return valarray_output(std::move(vals));
+}
+
+nanobind::object rand_binomial(
+  const int &n, const double &p, const int &size, std::shared_ptr<RandomState> random_state
+) {
+  check_size(size);
+  if (n < 0)
+    throw std::runtime_error("n must be non-negative");
+  if (p < 0 || p > 1)
+    throw std::runtime_error("p must be within [0, 1]");
+  std::valarray<int> vals(size);
+  {
+    RandomStateGuard guard(random_state);
+    f_rand_binomial_array(&n, &p, begin(vals), &size);
+  }
+  return valarray_output(std::move(vals));
+}
@@ -6,7 +6,60 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "nanobind/nanobind.h"
+
 extern "C" void f_pmc_srand(const int*);
 extern "C" void f_rand_normal(const double*, const double*, double*);
+extern "C" void f_rand_normal_array(const double*, const double*, double*, const int*) noexcept;
+extern "C" void f_rand_uniform_array(double*, const int*) noexcept;
+extern "C" void f_rand_poisson_array(const double*, int*, const int*) noexcept;
+extern "C" void f_rand_binomial_array(const int*, const double*, int*, const int*) noexcept;
+extern "C" void f_rand_state_size(int*) noexcept;
+extern "C" void f_rand_state_get(int*, const int*) noexcept;
+extern "C" void f_rand_state_put(const int*, const int*) noexcept;
 void rand_init(int seed);
 double rand_normal(double mean, double stddev);
+
+// seed of the given stream, computed directly from the stream index (splitmix64 is
+// counter-based so jumping ahead to any stream costs the same), a zero seed picks a random one
+int stream_seed(const uint64_t &seed, const uint64_t &stream);
+
+// generator state owned by an object rather than by the calling thread
+struct RandomState {
+    int seed;
+    std::vector<int> state;
+
+    RandomState(const int &seed, const int &stream);
+
+    static std::vector<int> thread_state();
+    static void set_thread_state(const std::vector<int> &state);
+};
+
+// swaps the given RandomState in as the calling thread's generator state for the lifetime
+// of the guard and stores the advanced state back on exit, no-op for nullptr (the guard
+// shares the ownership, so the state outlives e.g. reassigning AeroState.random_state from
+// Python while the GIL is released)
+class RandomStateGuard {
+    std::shared_ptr<RandomState> random_state;
+    std::vector<int> saved;
+  public:
+    explicit RandomStateGuard(std::shared_ptr<RandomState> random_state);
+    ~RandomStateGuard();
+    RandomStateGuard(const RandomStateGuard&) = delete;
+    RandomStateGuard &operator=(const RandomStateGuard&) = delete;
+};
+
+// bulk variants filling a NumPy array in a single call, from the given RandomState if not nullptr
+nanobind::object rand_normal_array(
+    const double &mean, const double &stddev, const int &n, std::shared_ptr<RandomState> random_state
+);
+nanobind::object rand_uniform(const int &n, std::shared_ptr<RandomState> random_state);
+nanobind::object rand_poisson(
+    const double &mean, const int &n, std::shared_ptr<RandomState> random_state
+);
+nanobind::object rand_binomial(
+    const int &n, const double &p, const int &size, std::shared_ptr<RandomState> random_state
+);
@@ -5,6 +5,7 @@
 ##################################################################################################*/
 
 #include "run_exact.hpp"
+#include "output.hpp"
 
 void run_exact(
     const BinGrid &bin_grid,
@@ -15,6 +16,7 @@ void run_exact(
     const EnvState &env_state,
     const RunExactOpt &run_exact_opt
 ) {
+    auto lock = output_lock(run_exact_opt.do_output);
     f_run_exact(
         bin_grid.ptr.f_arg(),
         gas_data.ptr.f_arg(),
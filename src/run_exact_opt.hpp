@@ -17,6 +17,7 @@ extern "C" void f_run_exact_opt_t_max(const void *ptr, double *t_max) noexcept;
 
 struct RunExactOpt {
     PMCResource ptr;
+    bool do_output;
 
     RunExactOpt(const nlohmann::json &json, EnvState &env_state) :
         ptr(f_run_exact_opt_ctor, f_run_exact_opt_dtor)
@@ -28,6 +29,7 @@ struct RunExactOpt {
         }))
             if (json_copy.find(key) == json_copy.end())
                 json_copy[key] = 0;
+        do_output = json_copy["t_output"].get<double>() > 0;
 
         JSONResourceGuard<InputJSONResource> guard(json_copy);
         f_run_exact_opt_from_json(this->ptr.f_arg(), env_state.ptr.f_arg());
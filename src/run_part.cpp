@@ -4,7 +4,17 @@
 # Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
 ##################################################################################################*/
 
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <random>
+#include <set>
+#include <thread>
 #include "run_part.hpp"
+#include "output.hpp"
+#include "output_sink.hpp"
+#include "rand.hpp"
+#include "util.hpp"
 
 void check_allow_flags(
     const AeroState &aero_state,
@@ -17,6 +27,110 @@ void check_allow_flags(
         throw std::runtime_error("allow halving/doubling flags set differently then while sampling");
 }
 
+// runs with the solvers that keep their state in module variables, and runs creating particles
+// (whose IDs come from a module-level counter) are serialised, others run fully concurrently
+std::unique_lock<std::mutex> serial_lock(
+    const RunPartOpt &run_part_opt,
+    const Scenario &scenario
+) {
+    return solver_lock(
+        !run_part_opt.thread_safe ||
+        run_part_opt.creates_particles ||
+        Scenario::creates_particles(scenario)
+    );
+}
+
+// whether the output is taken between time steps (see external_output_timestep()) rather
+// than written by PartMC, i.e. to an OutputSink or through an AsyncOutputWriter
+bool has_external_output(const RunPartOpt &run_part_opt) {
+    if (run_part_opt.output_sink && run_part_opt.async_writer)
+        throw std::runtime_error("output_sink and async_writer cannot be both set");
+    return run_part_opt.output_sink || run_part_opt.async_writer;
+}
+
+// PartMC's run_part() writes its files without a layout (see OutputLayout), these are hence
+// written here between the time steps as for external output
+bool has_output_layout(const RunPartOpt &run_part_opt) {
+    return run_part_opt.do_output && run_part_opt.output_layout.any();
+}
+
+// a time step with the output left to the caller, returns whether an output is due (i_output
+// is then already advanced); the caller holds serial_lock() and the RandomStateGuard
+bool external_output_timestep(
+    const Scenario &scenario,
+    EnvState &env_state,
+    const AeroData &aero_data,
+    AeroState &aero_state,
+    const GasData &gas_data,
+    GasState &gas_state,
+    const RunPartOpt &run_part_opt,
+    const CampCore &camp_core,
+    const Photolysis &photolysis,
+    const int &i_time,
+    const double &t_start,
+    double &last_output_time,
+    double &last_progress_time,
+    int &i_output
+) {
+    const bool external_output = true;
+    bool output_due;
+    f_run_part_timestep(
+        scenario.ptr.f_arg(),
+        env_state.ptr.f_arg_non_const(),
+        aero_data.ptr.f_arg(),
+        aero_state.ptr.f_arg_non_const(),
+        gas_data.ptr.f_arg(),
+        gas_state.ptr.f_arg_non_const(),
+        run_part_opt.ptr.f_arg(),
+        camp_core.ptr.f_arg(),
+        photolysis.ptr.f_arg(),
+        &i_time,
+        &t_start,
+        &last_output_time,
+        &last_progress_time,
+        &i_output,
+        &external_output,
+        &output_due
+    );
+    return output_due;
+}
+
+// writes the output file of the given index and repeat as PartMC's run_part() does (with
+// RunPartOpt's layout), holding output_lock() only for the time of writing, or queues it to
+// RunPartOpt.async_writer
+void write_output(
+    const RunPartOpt &run_part_opt,
+    const int &index,
+    const int &i_repeat,
+    const EnvState &env_state,
+    const AeroData &aero_data,
+    AeroState &aero_state,
+    const GasData &gas_data,
+    const GasState &gas_state
+) {
+    OutputRecord record;
+    char uuid[64];
+    const int uuid_size = sizeof(uuid);
+    record.index = index;
+    record.i_repeat = i_repeat;
+    record.time = EnvState::get_elapsed_time(env_state);
+    f_run_part_output_record(aero_state.ptr.f_arg_non_const(), run_part_opt.ptr.f_arg(),
+        &record.del_t, &record.record_removals, &record.record_optical, uuid, &uuid_size);
+    record.uuid = uuid;
+
+    if (run_part_opt.async_writer)
+        AsyncOutputWriter::enqueue(*run_part_opt.async_writer, run_part_opt.output_prefix,
+            aero_state, gas_state, env_state, record, run_part_opt.output_layout);
+    else {
+        auto lock = output_lock();
+        write_output_state(run_part_opt.output_prefix, aero_data, aero_state, gas_data,
+            gas_state, env_state, record, run_part_opt.output_layout);
+    }
+    // the removals are cleared as PartMC does after each output, with the async writer only
+    // once it has taken its copy of the state
+    f_aero_state_zero_removals(aero_state.ptr.f_arg_non_const());
+}
+
 void run_part(
     const Scenario &scenario,
     EnvState &env_state,
@@ -29,6 +143,24 @@ void run_part(
     const Photolysis &photolysis
 ) {
     check_allow_flags(aero_state, run_part_opt);
+    if (has_external_output(run_part_opt) || has_output_layout(run_part_opt)) {
+        // PartMC's run_part() writes its output itself, hence the time loop is done here
+        const int n_time = std::lround(
+            RunPartOpt::t_max(run_part_opt) / RunPartOpt::del_t(run_part_opt)
+        );
+        const double t_start = EnvState::get_elapsed_time(env_state);
+        double last_output_time = 0, last_progress_time = 0;
+        int i_output = 1;
+        for (int i_time = 1; i_time <= n_time; ++i_time)
+            run_part_timestep(scenario, env_state, aero_data, aero_state, gas_data, gas_state,
+                run_part_opt, camp_core, photolysis, i_time, t_start, last_output_time,
+                last_progress_time, i_output);
+        return;
+    }
+    ++aero_state.generation;
+    auto serial = serial_lock(run_part_opt, scenario);
+    auto lock = output_lock(run_part_opt.do_output);
+    RandomStateGuard guard(std::atomic_load(&aero_state.random_state));
     f_run_part(
         scenario.ptr.f_arg(),
         env_state.ptr.f_arg_non_const(),
@@ -59,22 +191,54 @@ std::tuple<double, double, int> run_part_timestep(
     int &i_output
 ) {
     check_allow_flags(aero_state, run_part_opt);
-    f_run_part_timestep(
-        scenario.ptr.f_arg(),
-        env_state.ptr.f_arg_non_const(),
-        aero_data.ptr.f_arg(),
-        aero_state.ptr.f_arg_non_const(),
-        gas_data.ptr.f_arg(),
-        gas_state.ptr.f_arg_non_const(),
-        run_part_opt.ptr.f_arg(),
-        camp_core.ptr.f_arg(),
-        photolysis.ptr.f_arg(),
-        &i_time,
-        &t_start,
-        &last_output_time,
-        &last_progress_time,
-        &i_output
-    );
+    ++aero_state.generation;
+    OutputSink *sink = run_part_opt.output_sink.get();
+    PendingSnapshots pending;
+    {
+        const bool external_output =
+            has_external_output(run_part_opt) || has_output_layout(run_part_opt);
+        auto serial = serial_lock(run_part_opt, scenario);
+        auto lock = output_lock(run_part_opt.do_output && !external_output);
+        RandomStateGuard guard(std::atomic_load(&aero_state.random_state));
+        bool output_due;
+        const bool initial =
+            EnvState::get_elapsed_time(env_state) < RunPartOpt::del_t(run_part_opt);
+        auto take_output = [&](const int &index) {
+            if (sink != nullptr) {
+                OutputSink::take(*sink, index, aero_state, gas_state, env_state, pending);
+                // the removals are not part of the snapshot, cleared as after a written file
+                f_aero_state_zero_removals(aero_state.ptr.f_arg_non_const());
+            }
+            else
+                write_output(run_part_opt, index, 1, env_state, aero_data, aero_state,
+                    gas_data, gas_state);
+        };
+        if (external_output && run_part_opt.do_output && initial)
+            take_output(1);
+        f_run_part_timestep(
+            scenario.ptr.f_arg(),
+            env_state.ptr.f_arg_non_const(),
+            aero_data.ptr.f_arg(),
+            aero_state.ptr.f_arg_non_const(),
+            gas_data.ptr.f_arg(),
+            gas_state.ptr.f_arg_non_const(),
+            run_part_opt.ptr.f_arg(),
+            camp_core.ptr.f_arg(),
+            photolysis.ptr.f_arg(),
+            &i_time,
+            &t_start,
+            &last_output_time,
+            &last_progress_time,
+            &i_output,
+            &external_output,
+            &output_due
+        );
+        if (output_due)
+            take_output(i_output);
+    }
+    // the sink's callback is only called once the locks and generator state are released
+    if (sink != nullptr)
+        OutputSink::deliver(*sink, pending);
 
     return std::make_tuple(last_output_time, last_progress_time, i_output);
 }
@@ -97,6 +261,18 @@ std::tuple<double, double, int> run_part_timeblock(
     int &i_output
 ) {
     check_allow_flags(aero_state, run_part_opt);
+    if (has_external_output(run_part_opt) || has_output_layout(run_part_opt)) {
+        // the output times within the block are taken between single time steps
+        for (int i = i_time; i <= i_next; ++i)
+            run_part_timestep(scenario, env_state, aero_data, aero_state, gas_data, gas_state,
+                run_part_opt, camp_core, photolysis, i, t_start, last_output_time,
+                last_progress_time, i_output);
+        return std::make_tuple(last_output_time, last_progress_time, i_output);
+    }
+    ++aero_state.generation;
+    auto serial = serial_lock(run_part_opt, scenario);
+    auto lock = output_lock(run_part_opt.do_output);
+    RandomStateGuard guard(std::atomic_load(&aero_state.random_state));
     f_run_part_timeblock(
         scenario.ptr.f_arg(),
         env_state.ptr.f_arg_non_const(),
@@ -117,3 +293,113 @@ std::tuple<double, double, int> run_part_timeblock(
 
     return std::make_tuple(last_output_time, last_progress_time, i_output);
 }
+
+std::vector<int> run_part_ensemble(
+    const Scenario &scenario,
+    const std::vector<EnvState*> &env_states,
+    const AeroData &aero_data,
+    const std::vector<AeroState*> &aero_states,
+    const GasData &gas_data,
+    const std::vector<GasState*> &gas_states,
+    const RunPartOpt &run_part_opt,
+    const CampCore &camp_core,
+    const Photolysis &photolysis,
+    const int &n_threads,
+    const int &seed
+) {
+    const auto n_members = aero_states.size();
+    if (env_states.size() != n_members || gas_states.size() != n_members)
+        throw std::runtime_error("env_states, aero_states and gas_states must be of equal length");
+    if (
+        std::set<const void*>(env_states.begin(), env_states.end()).size() != n_members ||
+        std::set<const void*>(aero_states.begin(), aero_states.end()).size() != n_members ||
+        std::set<const void*>(gas_states.begin(), gas_states.end()).size() != n_members
+    )
+        throw std::runtime_error("ensemble members must not share EnvState, AeroState or GasState instances");
+
+    if (run_part_opt.output_sink)
+        throw std::runtime_error("output_sink is not supported by run_part_ensemble()");
+
+    for (auto aero_state : aero_states) {
+        check_allow_flags(*aero_state, run_part_opt);
+        ++aero_state->generation;
+    }
+
+    // per-member seeds are the streams of a single seed (see RandomState) so that each member
+    // can be reproduced with rand_init(seeds[i]) and run_part(), members with their own
+    // AeroState.random_state keep using it and are reported with a zero seed
+    std::vector<int> seeds(n_members);
+    const uint64_t base = seed != 0 ? seed : std::random_device()();
+    for (size_t i = 0; i < n_members; ++i)
+        seeds[i] = std::atomic_load(&aero_states[i]->random_state) ? 0 : stream_seed(base, i);
+
+    // each member is stepped here (as run_part() with an output sink) so that output_lock()
+    // is only taken while writing its files and members with file output can run concurrently
+    // (if serial_lock() allows it)
+    const int n_time = std::lround(
+        RunPartOpt::t_max(run_part_opt) / RunPartOpt::del_t(run_part_opt)
+    );
+    auto run_member = [&](const size_t &i) {
+        const int i_repeat = i + 1;
+        auto &env_state = *env_states[i];
+        auto &aero_state = *aero_states[i];
+        auto &gas_state = *gas_states[i];
+        auto serial = serial_lock(run_part_opt, scenario);
+        RandomStateGuard guard(std::atomic_load(&aero_state.random_state));
+        if (seeds[i] != 0)
+            rand_init(seeds[i]);
+
+        const double t_start = EnvState::get_elapsed_time(env_state);
+        double last_output_time = 0, last_progress_time = 0;
+        int i_output = 1;
+        if (run_part_opt.do_output && t_start < RunPartOpt::del_t(run_part_opt))
+            write_output(run_part_opt, i_output, i_repeat, env_state, aero_data, aero_state,
+                gas_data, gas_state);
+        for (int i_time = 1; i_time <= n_time; ++i_time)
+            if (external_output_timestep(scenario, env_state, aero_data, aero_state, gas_data,
+                gas_state, run_part_opt, camp_core, photolysis, i_time, t_start,
+                last_output_time, last_progress_time, i_output)
+            )
+                write_output(run_part_opt, i_output, i_repeat, env_state, aero_data,
+                    aero_state, gas_data, gas_state);
+    };
+
+    // members are picked up by whichever pool thread is idle, the calling thread only waits
+    // (the generator state of the threads is reseeded per member)
+    std::atomic<size_t> next(0);
+    std::vector<std::exception_ptr> errors(n_members);
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < n_members;) {
+            try {
+                run_member(i);
+            }
+            catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    const size_t n_workers = std::max<size_t>(1, std::min<size_t>(
+        n_members,
+        n_threads > 0 ? n_threads : std::max(1u, std::thread::hardware_concurrency())
+    ));
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n_workers; ++i)
+        threads.emplace_back(worker);
+    for (auto &thread : threads)
+        thread.join();
+
+    for (size_t i = 0; i < n_members; ++i) {
+        if (errors[i]) {
+            try {
+                std::rethrow_exception(errors[i]);
+            }
+            catch (const std::exception &e) {
+                throw std::runtime_error(
+                    "ensemble member " + std::to_string(i) + " failed: " + e.what()
+                );
+            }
+        }
+    }
+    return seeds;
+}
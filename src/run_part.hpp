@@ -27,6 +27,16 @@ extern "C" void f_run_part(
     const void*
 ) noexcept;
 
+extern "C" void f_run_part_output_record(
+    const void*,
+    const void*,
+    double*,
+    bool*,
+    bool*,
+    char*,
+    const int*
+) noexcept;
+
 extern "C" void f_run_part_timestep(
     const void*,
     void*,
@@ -41,7 +51,9 @@ extern "C" void f_run_part_timestep(
     const double*,
     double*,
     double*,
-    int*
+    int*,
+    const bool*,
+    bool*
 ) noexcept;
 
 extern "C" void f_run_part_timeblock(
@@ -108,3 +120,17 @@ std::tuple<double, double, int> run_part_timeblock(
     double &last_progress_time,
     int &i_output
 );
+
+std::vector<int> run_part_ensemble(
+    const Scenario &scenario,
+    const std::vector<EnvState*> &env_states,
+    const AeroData &aero_data,
+    const std::vector<AeroState*> &aero_states,
+    const GasData &gas_data,
+    const std::vector<GasState*> &gas_states,
+    const RunPartOpt &run_part_opt,
+    const CampCore &camp_core,
+    const Photolysis &photolysis,
+    const int &n_threads,
+    const int &seed
+);
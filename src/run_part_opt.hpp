@@ -6,8 +6,10 @@
 
 #pragma once
 
+#include <memory>
 #include "pmc_resource.hpp"
 #include "json_resource.hpp"
+#include "output_layout.hpp"
 
 extern "C" void f_run_part_opt_ctor(void *ptr) noexcept;
 extern "C" void f_run_part_opt_dtor(void *ptr) noexcept;
@@ -15,9 +17,16 @@ extern "C" void f_run_part_opt_from_json(const void *ptr) noexcept;
 extern "C" void f_run_part_opt_t_max(const void *ptr, double *t_max) noexcept;
 extern "C" void f_run_part_opt_del_t(const void *ptr, double *del_t) noexcept;
 
+struct OutputSink;
+struct AsyncOutputWriter;
+
 struct RunPartOpt {
     PMCResource ptr;
-    bool allow_halving, allow_doubling;
+    bool allow_halving, allow_doubling, do_output, thread_safe, creates_particles;
+    std::shared_ptr<OutputSink> output_sink;  // if set, receives the output instead of files
+    std::shared_ptr<AsyncOutputWriter> async_writer;  // if set, writes the files
+    std::string output_prefix;
+    OutputLayout output_layout;
 
     RunPartOpt(const nlohmann::json &json) :
         ptr(f_run_part_opt_ctor, f_run_part_opt_dtor)
@@ -29,7 +38,7 @@ struct RunPartOpt {
         json_copy["do_parallel"] = false;
 
         for (auto key : std::set<std::string>({
-            "do_mosaic", "do_camp_chem", "do_condensation", "do_nucleation",
+            "do_mosaic", "do_camp_chem", "do_condensation", "do_nucleation", "record_removals",
         }))
             if (json_copy.find(key) == json_copy.end())
                 json_copy[key] = false;
@@ -42,11 +51,38 @@ struct RunPartOpt {
         allow_halving = json_copy["allow_halving"];
         allow_doubling = json_copy["allow_doubling"];
 
+        // PartMC keeps the condensation, MOSAIC and CAMP solver state in module variables
+        thread_safe = !(
+            json_copy["do_condensation"].get<bool>() ||
+            json_copy["do_mosaic"].get<bool>() ||
+            json_copy["do_camp_chem"].get<bool>()
+        );
+        // new particles (coagulated, doubled or nucleated) take their IDs from a single
+        // module-level counter, see also Scenario::creates_particles()
+        creates_particles =
+            json_copy.value("do_coagulation", true) ||
+            allow_doubling ||
+            json_copy["do_nucleation"].get<bool>();
+
         for (auto key : std::set<std::string>({
             "t_output", "t_progress", "rand_init"
         }))
             if (json_copy.find(key) == json_copy.end())
                 json_copy[key] = 0;
+        do_output = json_copy["t_output"].get<double>() > 0;
+
+        // handled here and not by PartMC (see OutputLayout)
+        output_layout = OutputLayout(
+            json_copy.value("output_chunk_size", 0),
+            json_copy.value("output_deflate_level", 0),
+            json_copy.value("output_shuffle", false)
+        );
+        for (auto key : std::set<std::string>({
+            "output_chunk_size", "output_deflate_level", "output_shuffle"
+        }))
+            json_copy.erase(key);
+        if (json_copy.find("output_prefix") != json_copy.end())
+            output_prefix = json_copy["output_prefix"].get<std::string>();
 
         JSONResourceGuard<InputJSONResource> guard(json_copy);
         f_run_part_opt_from_json(this->ptr.f_arg());
@@ -5,6 +5,7 @@
 ##################################################################################################*/
 
 #include "run_sect.hpp"
+#include "output.hpp"
 
 void run_sect(
     const BinGrid &bin_grid,
@@ -15,6 +16,7 @@ void run_sect(
     const EnvState &env_state,
     const RunSectOpt &run_sect_opt
 ) {
+    auto lock = output_lock(run_sect_opt.do_output);
     f_run_sect(
         bin_grid.ptr.f_arg(),
         gas_data.ptr.f_arg(),
@@ -18,6 +18,7 @@ extern "C" void f_run_sect_opt_del_t(const void *ptr, double *del_t) noexcept;
 
 struct RunSectOpt {
     PMCResource ptr;
+    bool do_output;
 
     RunSectOpt(const nlohmann::json &json, EnvState &env_state) :
         ptr(f_run_sect_opt_ctor, f_run_sect_opt_dtor)
@@ -29,6 +30,7 @@ struct RunSectOpt {
         }))
             if (json_copy.find(key) == json_copy.end())
                 json_copy[key] = 0;
+        do_output = json_copy["t_output"].get<double>() > 0;
 
         JSONResourceGuard<InputJSONResource> guard(json_copy);
         f_run_sect_opt_from_json(this->ptr.f_arg(), env_state.ptr.f_arg());
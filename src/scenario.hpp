@@ -234,6 +234,15 @@ struct Scenario {
         return times;
     }
 
+    // whether emissions or dilution with the background add particles (and take IDs from
+    // PartMC's module-level counter) at any time
+    static bool creates_particles(const Scenario &self) {
+        for (auto rates : {emission_rate_scale(self), aero_dilution_rate(self)})
+            for (auto rate : rates)
+                if (rate != 0)
+                    return true;
+        return false;
+    }
 };
 
 double loss_rate(
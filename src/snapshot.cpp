@@ -0,0 +1,117 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include "output.hpp"
+#include "snapshot.hpp"
+
+namespace {
+    std::string pack(
+        const AeroData &aero_data,
+        const AeroState *aero_state,
+        const GasData &gas_data,
+        const GasState *gas_state,
+        const EnvState *env_state,
+        const bool &with_metadata,
+        const bool &with_states
+    ) {
+        void *null = nullptr, *memory = nullptr;
+        std::size_t size = 0;
+        {
+            auto lock = output_lock();
+            f_state_pack(
+                aero_data.ptr.f_arg(),
+                aero_state ? aero_state->ptr.f_arg() : &null,
+                gas_data.ptr.f_arg(),
+                gas_state ? gas_state->ptr.f_arg() : &null,
+                env_state ? env_state->ptr.f_arg() : &null,
+                &with_metadata,
+                &with_states,
+                &memory,
+                &size
+            );
+        }
+        std::string data(static_cast<const char*>(memory), size);
+        std::free(memory);
+        return data;
+    }
+
+    void unpack(
+        const std::string &data,
+        const AeroData &aero_data,
+        const AeroState *aero_state,
+        const GasData &gas_data,
+        const GasState *gas_state,
+        const EnvState *env_state,
+        const bool &with_metadata,
+        const bool &with_states
+    ) {
+        if (data.empty())
+            throw std::runtime_error("empty snapshot buffer");
+        void *null = nullptr;
+        // opened read-only, netCDF does not modify the buffer
+        void *memory = const_cast<char*>(data.data());
+        const std::size_t size = data.size();
+        auto lock = output_lock();
+        f_state_unpack(
+            &memory,
+            &size,
+            aero_data.ptr.f_arg(),
+            aero_state ? aero_state->ptr.f_arg() : &null,
+            gas_data.ptr.f_arg(),
+            gas_state ? gas_state->ptr.f_arg() : &null,
+            env_state ? env_state->ptr.f_arg() : &null,
+            &with_metadata,
+            &with_states
+        );
+    }
+}
+
+StateSnapshot::StateSnapshot(
+    const AeroState &aero_state,
+    const GasState &gas_state,
+    const EnvState &env_state
+) :
+    aero_data(aero_state.aero_data),
+    gas_data(gas_state.gas_data),
+    allow_halving(aero_state.allow_halving),
+    allow_doubling(aero_state.allow_doubling)
+{
+    this->data = pack(*this->aero_data, &aero_state, *this->gas_data, &gas_state, &env_state,
+        false, true);
+}
+
+StateSnapshot::StateSnapshot(
+    const std::string &data,
+    const std::string &metadata,
+    const int &allow_halving,
+    const int &allow_doubling
+) :
+    data(data),
+    aero_data(new AeroData()),
+    gas_data(new GasData()),
+    allow_halving(allow_halving),
+    allow_doubling(allow_doubling)
+{
+    unpack(metadata, *this->aero_data, nullptr, *this->gas_data, nullptr, nullptr, true, false);
+}
+
+std::tuple<AeroState*, GasState*, EnvState*> StateSnapshot::restore(const StateSnapshot &self) {
+    auto aero_state = std::make_unique<AeroState>(self.aero_data);
+    auto gas_state = std::make_unique<GasState>(self.gas_data);
+    auto env_state = std::make_unique<EnvState>();
+    aero_state->allow_halving = self.allow_halving;
+    aero_state->allow_doubling = self.allow_doubling;
+    unpack(self.data, *self.aero_data, aero_state.get(), *self.gas_data, gas_state.get(),
+        env_state.get(), false, true);
+    return std::make_tuple(aero_state.release(), gas_state.release(), env_state.release());
+}
+
+std::string StateSnapshot::metadata(const StateSnapshot &self) {
+    return pack(*self.aero_data, nullptr, *self.gas_data, nullptr, nullptr, true, false);
+}
@@ -0,0 +1,71 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <tuple>
+#include "aero_state.hpp"
+#include "env_state.hpp"
+#include "gas_state.hpp"
+
+extern "C" void f_state_pack(
+    const void *aero_data,
+    const void *aero_state,
+    const void *gas_data,
+    const void *gas_state,
+    const void *env_state,
+    const bool *with_metadata,
+    const bool *with_states,
+    void **memory,
+    std::size_t *size
+) noexcept;
+
+extern "C" void f_state_unpack(
+    void *const *memory,
+    const std::size_t *size,
+    const void *aero_data,
+    const void *aero_state,
+    const void *gas_data,
+    const void *gas_state,
+    const void *env_state,
+    const bool *with_metadata,
+    const bool *with_states
+) noexcept;
+
+// (AeroState, GasState, EnvState) serialised into a single in-memory netCDF-4 buffer;
+// the species metadata (AeroData, GasData) is not part of the buffer but shared with the
+// states restored from it, and serialised separately only when pickled
+struct StateSnapshot {
+    std::string data;
+    std::shared_ptr<AeroData> aero_data;
+    std::shared_ptr<GasData> gas_data;
+    int allow_halving = -1, allow_doubling = -1;
+
+    StateSnapshot(
+        const AeroState &aero_state,
+        const GasState &gas_state,
+        const EnvState &env_state
+    );
+
+    StateSnapshot(
+        const std::string &data,
+        const std::string &metadata,
+        const int &allow_halving,
+        const int &allow_doubling
+    );
+
+    static std::tuple<AeroState*, GasState*, EnvState*> restore(const StateSnapshot &self);
+
+    // the species metadata in the format of the data buffer
+    static std::string metadata(const StateSnapshot &self);
+
+    static std::size_t __len__(const StateSnapshot &self) {
+        return self.data.size();
+    }
+};
@@ -0,0 +1,55 @@
+/*##################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+##################################################################################################*/
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// name -> (0-based) index map of the species of an AeroData or GasData, built on first use
+// (the species list of a constructed or read-in AeroData/GasData does not change afterwards)
+// and then read-only, replacing the per-lookup linear search on the Fortran side
+class SpecIndex {
+    std::unordered_map<std::string, int> index;
+
+  public:
+    template <typename NameByIndex>
+    SpecIndex(const int &len, NameByIndex name_by_index) {
+        this->index.reserve(len);
+        for (int idx = 0; idx < len; ++idx)
+            this->index.emplace(name_by_index(idx), idx);
+    }
+
+    int at(const std::string &name) const {
+        const auto it = this->index.find(name);
+        if (it == this->index.end())
+            throw std::runtime_error("Element not found.");
+        return it->second;
+    }
+
+    std::vector<int> at(const std::vector<std::string> &names) const {
+        std::vector<int> indices(names.size());
+        for (size_t i = 0; i < names.size(); ++i)
+            indices[i] = this->at(names[i]);
+        return indices;
+    }
+};
+
+class LazySpecIndex {
+    mutable std::once_flag built;
+    mutable std::unique_ptr<const SpecIndex> index;
+
+  public:
+    template <typename Builder>
+    const SpecIndex &get(Builder builder) const {
+        std::call_once(this->built, [&]() { this->index.reset(new SpecIndex(builder())); });
+        return *this->index;
+    }
+};
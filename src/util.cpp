@@ -4,8 +4,18 @@
 # Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
 ##################################################################################################*/
 
+#include <cmath>
 #include "util.hpp"
 
+std::unique_lock<std::mutex> solver_lock(const bool &serialise) {
+    static std::mutex mutex;
+    return serialise
+        ? std::unique_lock<std::mutex>(mutex)
+        : std::unique_lock<std::mutex>(mutex, std::defer_lock);
+}
+
+static constexpr double pi = 3.14159265358979323846;
+
 int pow2_above(int n) {
     int res;
     py_pow2_above(&n, &res);
@@ -35,3 +45,19 @@ double diam2rad(double d) {
     f_diam2rad(&d, &rad);
     return rad;
 }
+
+nanobind::object sphere_vol2rad_array(const ConstDoubleArray &v) {
+    return map_array(v, [](double v) { return std::cbrt(v * (3 / (4 * pi))); });
+}
+
+nanobind::object rad2diam_array(const ConstDoubleArray &rad) {
+    return map_array(rad, [](double rad) { return 2 * rad; });
+}
+
+nanobind::object sphere_rad2vol_array(const ConstDoubleArray &rad) {
+    return map_array(rad, [](double rad) { return (4 * pi / 3) * rad * rad * rad; });
+}
+
+nanobind::object diam2rad_array(const ConstDoubleArray &d) {
+    return map_array(d, [](double d) { return d / 2; });
+}
@@ -6,17 +6,31 @@
 
 #pragma once
 
+#include <mutex>
+#include "ndarray_output.hpp"
+
 extern "C" void py_pow2_above(int*, int*);
 extern "C" void f_sphere_vol2rad(const double*, double*);
 extern "C" void f_rad2diam(const double*, double*);
 extern "C" void f_sphere_rad2vol(const double*, double*);
 extern "C" void f_diam2rad(const double*, double*);
 
+// PartMC keeps the condensation, MOSAIC and CAMP solver state as well as the counter of
+// particle IDs in module variables, hence calls using these solvers or creating particles
+// are serialised with a single lock (a no-op if serialise is false)
+std::unique_lock<std::mutex> solver_lock(const bool &serialise = true);
+
 int pow2_above(int n);
 double sphere_vol2rad(double v);
 double rad2diam(double rad);
 double sphere_rad2vol(double rad);
 double diam2rad(double d);
 
+// array variants evaluated in C++ without a Fortran call per element
+nanobind::object sphere_vol2rad_array(const ConstDoubleArray &v);
+nanobind::object rad2diam_array(const ConstDoubleArray &rad);
+nanobind::object sphere_rad2vol_array(const ConstDoubleArray &rad);
+nanobind::object diam2rad_array(const ConstDoubleArray &d);
+
 extern "C" double py_deg2rad(double);
 
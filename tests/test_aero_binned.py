@@ -65,3 +65,24 @@ class TestAeroBinned:
             ),
             rtol=1e-6,
         )
+
+    @staticmethod
+    def test_vol_conc_shape():
+        # arrange
+        grid_size = 40
+        bin_grid = ppmc.BinGrid(grid_size, "log", 1e-9, 1e-5)
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_MINIMAL)
+        aero_dist = ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_MINIMAL)
+        sut = ppmc.AeroBinned(aero_data, bin_grid)
+        sut.add_aero_dist(bin_grid, aero_dist)
+
+        # act
+        vol_conc = sut.vol_conc
+        vol_conc_transposed = sut.vol_conc_transposed
+
+        # assert
+        assert isinstance(vol_conc, np.ndarray)
+        assert vol_conc.shape == (len(aero_data), grid_size)
+        assert vol_conc.flags.c_contiguous
+        assert vol_conc_transposed.shape == (grid_size, len(aero_data))
+        np.testing.assert_array_equal(vol_conc_transposed, vol_conc.T)
@@ -5,6 +5,7 @@
 ####################################################################################################
 
 import platform
+from concurrent.futures import ThreadPoolExecutor
 
 import numpy as np
 import pytest
@@ -55,6 +56,25 @@ class TestAeroData:
         # assert
         assert sut is not None
 
+    @staticmethod
+    def test_ctor_concurrent():
+        # arrange
+        n_threads = 8
+
+        # act
+        with ThreadPoolExecutor(max_workers=n_threads) as executor:
+            suts = list(
+                executor.map(
+                    lambda _: ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL),
+                    range(4 * n_threads),
+                )
+            )
+
+        # assert
+        for sut in suts:
+            assert sut.species == suts[0].species
+            assert sut.densities == suts[0].densities
+
     @staticmethod
     def test_spec_by_name_found():
         # arrange
@@ -79,6 +99,32 @@ class TestAeroData:
         except RuntimeError as error:
             assert str(error) == "Element not found."
 
+    @staticmethod
+    def test_spec_indices():
+        # arrange
+        sut = ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL)
+        names = list(reversed(sut.species))
+
+        # act
+        indices = sut.spec_indices(names)
+
+        # assert
+        assert list(indices) == [sut.spec_by_name(name) for name in names]
+        assert list(indices) == list(reversed(range(len(sut))))
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_spec_indices_not_found():
+        # arrange
+        sut = ppmc.AeroData(AERO_DATA_CTOR_ARG_MINIMAL)
+
+        # act
+        with pytest.raises(RuntimeError) as exc_info:
+            sut.spec_indices(["H2O", "XXX"])
+
+        # assert
+        assert str(exc_info.value) == "Element not found."
+
     @staticmethod
     def test_len():
         # arrange
@@ -295,6 +341,34 @@ class TestAeroData:
             ),
         )
 
+    @staticmethod
+    @pytest.mark.parametrize("fun", ("rad2vol", "vol2rad", "diam2vol", "vol2diam"))
+    @pytest.mark.parametrize(
+        "aero_data_params",
+        (
+            {},
+            {"frac_dim": 2.4, "vol_fill_factor": 1.2, "prime_radius": 1e-7},
+            {"frac_dim": 2.2, "vol_fill_factor": 1.3, "prime_radius": 1e-6},
+        ),
+    )
+    def test_conversions_array(fun, aero_data_params: dict):
+        # arrange
+        sut = ppmc.AeroData(AERO_DATA_CTOR_ARG_MINIMAL)
+        for key, value in aero_data_params.items():
+            setattr(sut, key, value)
+        args = np.logspace(-20, -5, 12).reshape(3, 4)
+
+        # act
+        values = getattr(sut, fun)(args)
+
+        # assert
+        assert values.shape == args.shape
+        np.testing.assert_allclose(
+            values.ravel(),
+            [getattr(sut, fun)(arg) for arg in args.ravel()],
+            rtol=1e-12,
+        )
+
     @staticmethod
     def test_aero_data_densities():
         # arrange
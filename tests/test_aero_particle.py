@@ -49,6 +49,32 @@ class TestAeroParticle:  # pylint: disable=too-many-public-methods
         # assert
         assert sut.volumes == volumes
 
+    @staticmethod
+    @pytest.mark.parametrize(
+        "volumes",
+        (
+            np.asarray([3, 2, 1], dtype=np.float64),
+            np.asarray([3, 2, 1], dtype=np.float32),
+            np.asarray([3, 2, 1], dtype=np.int64),
+            np.asarray([3, 0, 2, 0, 1, 0], dtype=np.float64)[::2],
+            np.asarray([1, 2, 3], dtype=np.float64)[::-1],
+        ),
+    )
+    def test_ctor_ndarray(volumes):
+        # arrange
+        aero_data_arg = (
+            {"H2O": [1000 * si.kg / si.m**3, 0, 18e-3 * si.kg / si.mol, 0]},
+            {"Cl": [2200 * si.kg / si.m**3, 1, 35.5e-3 * si.kg / si.mol, 0]},
+            {"Na": [2200 * si.kg / si.m**3, 1, 23e-3 * si.kg / si.mol, 0]},
+        )
+        aero_data = ppmc.AeroData(aero_data_arg)
+
+        # act
+        sut = ppmc.AeroParticle(aero_data, volumes)
+
+        # assert
+        assert sut.volumes == [3, 2, 1]
+
     @staticmethod
     def test_volume():
         # arrange
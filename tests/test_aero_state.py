@@ -129,16 +129,34 @@ class TestAeroState:
         num_concs = sut_minimal.num_concs
 
         # assert
-        assert isinstance(num_concs, list)
+        assert isinstance(num_concs, np.ndarray)
         assert len(num_concs) == len(sut_minimal)
 
+    @staticmethod
+    def test_list_output(sut_minimal):
+        # arrange
+        ppmc.set_list_output(True)
+
+        # act
+        try:
+            masses = sut_minimal.masses()
+            ids = sut_minimal.ids
+        finally:
+            ppmc.set_list_output(False)
+
+        # assert
+        assert isinstance(masses, list)
+        assert isinstance(ids, list)
+        assert len(masses) == len(sut_minimal)
+        np.testing.assert_array_equal(masses, sut_minimal.masses())
+
     @staticmethod
     def test_masses(sut_minimal):
         # act
         masses = sut_minimal.masses()
 
         # assert
-        assert isinstance(masses, list)
+        assert isinstance(masses, np.ndarray)
         assert len(masses) == len(sut_minimal)
 
     @staticmethod
@@ -153,7 +171,7 @@ class TestAeroState:
             masses_so4[i_part] = sut_full.particle(i_part).species_masses[so4_ind]
 
         # assert
-        assert isinstance(masses, list)
+        assert isinstance(masses, np.ndarray)
         assert len(masses) == len(sut_full)
         np.testing.assert_allclose(masses_so4, masses)
 
@@ -166,7 +184,7 @@ class TestAeroState:
             masses_so4[i_part] = sut_full.particle(i_part).species_mass(1)
 
         # assert
-        assert isinstance(masses, list)
+        assert isinstance(masses, np.ndarray)
         assert len(masses) == len(sut_full)
         np.testing.assert_allclose(masses_so4, masses)
 
@@ -176,7 +194,7 @@ class TestAeroState:
         masses = sut_full.masses(include=["SO4"], exclude=["SO4"])
 
         # assert
-        assert isinstance(masses, list)
+        assert isinstance(masses, np.ndarray)
         assert len(masses) == len(sut_full)
         assert np.sum(masses) == 0.0
 
@@ -186,7 +204,7 @@ class TestAeroState:
         volumes = sut_minimal.volumes()
 
         # assert
-        assert isinstance(volumes, list)
+        assert isinstance(volumes, np.ndarray)
         assert len(volumes) == len(sut_minimal)
 
     @staticmethod
@@ -201,7 +219,7 @@ class TestAeroState:
             vol_so4[i_part] = sut_full.particle(i_part).volumes[so4_ind]
 
         # assert
-        assert isinstance(volumes, list)
+        assert isinstance(volumes, np.ndarray)
         assert len(volumes) == len(sut_full)
         np.testing.assert_allclose(vol_so4, volumes)
 
@@ -211,7 +229,7 @@ class TestAeroState:
         volumes = sut_full.volumes(include=["SO4"], exclude=["SO4"])
 
         # assert
-        assert isinstance(volumes, list)
+        assert isinstance(volumes, np.ndarray)
         assert len(volumes) == len(sut_full)
         assert np.sum(volumes) == 0.0
 
@@ -230,7 +248,7 @@ class TestAeroState:
             )
 
         # assert
-        assert isinstance(volumes, list)
+        assert isinstance(volumes, np.ndarray)
         assert len(volumes) == len(sut_full)
         np.testing.assert_allclose(vol_so4, volumes)
 
@@ -240,7 +258,7 @@ class TestAeroState:
         dry_diameters = sut_minimal.dry_diameters
 
         # assert
-        assert isinstance(dry_diameters, list)
+        assert isinstance(dry_diameters, np.ndarray)
         assert len(dry_diameters) == len(sut_minimal)
 
     @staticmethod
@@ -252,7 +270,7 @@ class TestAeroState:
         diameters = sut_minimal.mobility_diameters(env_state)
 
         # assert
-        assert isinstance(diameters, list)
+        assert isinstance(diameters, np.ndarray)
         assert len(diameters) == len(sut_minimal)
         assert (np.asarray(diameters) > 0).all()
 
@@ -262,7 +280,7 @@ class TestAeroState:
         diameters = sut_minimal.diameters()
 
         # assert
-        assert isinstance(diameters, list)
+        assert isinstance(diameters, np.ndarray)
         assert len(diameters) == len(sut_minimal)
 
     @staticmethod
@@ -271,7 +289,7 @@ class TestAeroState:
         ids = sut_minimal.ids
 
         # assert
-        assert isinstance(ids, list)
+        assert isinstance(ids, np.ndarray)
         assert len(ids) == len(sut_minimal)
         assert (np.asarray(ids) > 0).all()
 
@@ -286,11 +304,258 @@ class TestAeroState:
         crit_rel_humids = sut_full.crit_rel_humids(env_state)
 
         # assert
-        assert isinstance(crit_rel_humids, list)
+        assert isinstance(crit_rel_humids, np.ndarray)
         assert len(crit_rel_humids) == len(sut_full)
         assert (np.asarray(crit_rel_humids) > 1).all()
         assert (np.asarray(crit_rel_humids) < 1.2).all()
 
+    @staticmethod
+    def test_extract(sut_full):
+        # arrange
+        env_state = ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL)
+        env_state.set_temperature(300)
+        env_state.pressure = 1e5
+
+        # act
+        columns = sut_full.extract(
+            fields=[
+                "num_concs",
+                "masses",
+                "volumes",
+                "diameters",
+                "dry_diameters",
+                "mobility_diameters",
+                "crit_rel_humids",
+                "ids",
+            ],
+            env_state=env_state,
+        )
+
+        # assert
+        np.testing.assert_allclose(columns["num_concs"], sut_full.num_concs)
+        np.testing.assert_allclose(columns["masses"], sut_full.masses())
+        np.testing.assert_allclose(columns["volumes"], sut_full.volumes())
+        np.testing.assert_allclose(columns["diameters"], sut_full.diameters())
+        np.testing.assert_allclose(columns["dry_diameters"], sut_full.dry_diameters)
+        np.testing.assert_allclose(
+            columns["mobility_diameters"], sut_full.mobility_diameters(env_state)
+        )
+        np.testing.assert_allclose(
+            columns["crit_rel_humids"], sut_full.crit_rel_humids(env_state)
+        )
+        np.testing.assert_array_equal(columns["ids"], sut_full.ids)
+        assert columns["ids"].dtype == np.int64
+
+    @staticmethod
+    def test_extract_list_output(sut_full):
+        # arrange
+        ppmc.set_list_output(True)
+
+        # act
+        try:
+            columns = sut_full.extract(fields=["num_concs", "ids"])
+            ids = sut_full.ids
+        finally:
+            ppmc.set_list_output(False)
+
+        # assert
+        assert isinstance(columns["num_concs"], list)
+        assert columns["ids"] == ids
+        assert all(isinstance(particle_id, int) for particle_id in columns["ids"])
+
+    @staticmethod
+    def test_extract_include_exclude(sut_full):
+        # act
+        columns = sut_full.extract(
+            fields=["masses", "diameters"], include=["SO4", "BC"], exclude=["BC"]
+        )
+
+        # assert
+        assert list(columns.keys()) == ["masses", "diameters"]
+        np.testing.assert_allclose(columns["masses"], sut_full.masses(include=["SO4"]))
+        np.testing.assert_allclose(
+            columns["diameters"], sut_full.diameters(include=["SO4"])
+        )
+
+    @staticmethod
+    def test_to_columns(sut_full):
+        # act
+        columns = sut_full.to_columns(time=60.0)
+
+        # assert
+        names = list(columns.keys())
+        assert names[:4] == ["id", "num_conc", "least_create_time", "greatest_create_time"]
+        assert names[-1] == "time"
+        volume_names = [name for name in names if name.startswith("volume.")]
+        np.testing.assert_array_equal(columns["id"], sut_full.ids)
+        np.testing.assert_allclose(columns["num_conc"], sut_full.num_concs)
+        np.testing.assert_allclose(
+            np.stack([columns[name] for name in volume_names], axis=1),
+            sut_full.species_volumes(),
+        )
+        assert (columns["time"] == 60.0).all()
+
+    @staticmethod
+    def test_column_batch_outlives_aero_state(sut_minimal):
+        # arrange
+        num_concs = sut_minimal.num_concs
+
+        # act
+        columns = sut_minimal.column_batch().to_columns()
+        del sut_minimal
+        gc.collect()
+
+        # assert
+        np.testing.assert_allclose(columns["num_conc"], num_concs)
+
+    @staticmethod
+    def test_to_arrow(sut_full):
+        # arrange
+        pyarrow = pytest.importorskip("pyarrow")
+        batch = sut_full.column_batch()
+
+        # act
+        record_batch = sut_full.to_arrow()
+
+        # assert
+        assert isinstance(record_batch, pyarrow.RecordBatch)
+        assert record_batch.num_rows == len(sut_full)
+        assert record_batch.schema.names == batch.names
+        assert record_batch.schema.field("id").type == pyarrow.int64()
+        np.testing.assert_allclose(
+            record_batch.column("num_conc").to_numpy(), sut_full.num_concs
+        )
+
+    @staticmethod
+    def test_arrow_file_writer(sut_minimal, tmp_path):
+        # arrange
+        pyarrow = pytest.importorskip("pyarrow")
+        path = str(tmp_path / "particles.arrow")
+
+        # act
+        with ppmc.ArrowFileWriter(path) as writer:
+            writer.write(sut_minimal, time=0.0)
+            writer.write(sut_minimal, time=1.0)
+
+        # assert
+        with pyarrow.ipc.open_file(path) as reader:
+            assert reader.num_record_batches == 2
+            table = reader.read_all()
+        assert table.num_rows == 2 * len(sut_minimal)
+        assert sorted(set(table.column("time").to_pylist())) == [0.0, 1.0]
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_extract_fails_on_unknown_field(sut_minimal):
+        with pytest.raises(RuntimeError) as exc_info:
+            sut_minimal.extract(fields=["masses", "bogus"])
+        assert str(exc_info.value).startswith("unknown field 'bogus'")
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_extract_fails_without_env_state(sut_minimal):
+        with pytest.raises(RuntimeError) as exc_info:
+            sut_minimal.extract(fields=["crit_rel_humids"])
+        assert str(exc_info.value) == "field 'crit_rel_humids' requires env_state"
+
+    @staticmethod
+    def test_extract_kappas(sut_full):
+        # act
+        columns = sut_full.extract(fields=["kappas"])
+
+        # assert
+        for i_part in (0, len(sut_full) - 1):
+            np.testing.assert_allclose(
+                columns["kappas"][i_part], sut_full.particle(i_part).solute_kappa
+            )
+
+    @staticmethod
+    @pytest.mark.parametrize(
+        "weight, factor",
+        (("num_conc", None), ("mass_conc", "masses"), ("volume_conc", "volumes")),
+    )
+    def test_histogram_1d(sut_full, weight, factor):
+        # arrange
+        grid = ppmc.BinGrid(20, "log", 1e-9, 1e-5)
+        weights = np.asarray(sut_full.num_concs)
+        if factor is not None:
+            weights = weights * getattr(sut_full, factor)()
+
+        # act
+        hist = sut_full.histogram("dry_diameter", grid, weight=weight)
+
+        # assert
+        np.testing.assert_allclose(
+            hist, ppmc.histogram_1d(grid, sut_full.dry_diameters, weights), rtol=1e-12
+        )
+
+    @staticmethod
+    def test_histogram_2d(sut_full):
+        # arrange
+        x_grid = ppmc.BinGrid(20, "log", 1e-9, 1e-5)
+        y_grid = ppmc.BinGrid(10, "linear", 0, 1.5)
+        kappas = sut_full.extract(fields=["kappas"])["kappas"]
+
+        # act
+        hist = sut_full.histogram(
+            "diameter", x_grid, y="kappa", y_grid=y_grid, include=["SO4"]
+        )
+
+        # assert
+        assert hist.shape == (len(x_grid), len(y_grid))
+        np.testing.assert_allclose(
+            hist,
+            ppmc.histogram_2d(
+                x_grid,
+                sut_full.diameters(include=["SO4"]),
+                y_grid,
+                kappas,
+                sut_full.num_concs,
+            ),
+            rtol=1e-12,
+        )
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_histogram_fails_without_y_grid(sut_minimal):
+        grid = ppmc.BinGrid(10, "log", 1e-9, 1e-5)
+        with pytest.raises(RuntimeError) as exc_info:
+            sut_minimal.histogram("diameter", grid, y="kappa")
+        assert str(exc_info.value) == "y and y_grid must be given together"
+
+    @staticmethod
+    def test_species_volumes(sut_full):
+        # act
+        volumes = sut_full.species_volumes()
+
+        # assert
+        assert volumes.shape == (len(sut_full), len(sut_full.particle(0).volumes))
+        assert volumes.flags.c_contiguous
+        for i_part in (0, len(sut_full) // 2, len(sut_full) - 1):
+            np.testing.assert_array_equal(
+                volumes[i_part], sut_full.particle(i_part).volumes
+            )
+        np.testing.assert_allclose(volumes.sum(axis=1), sut_full.volumes())
+
+    @staticmethod
+    def test_set_species_volumes(sut_full):
+        # arrange
+        volumes = sut_full.species_volumes()
+
+        # act
+        sut_full.set_species_volumes(2 * volumes)
+
+        # assert
+        np.testing.assert_allclose(sut_full.species_volumes(), 2 * volumes)
+        np.testing.assert_allclose(sut_full.volumes(), 2 * volumes.sum(axis=1))
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_set_species_volumes_shape_mismatch(sut_full):
+        with pytest.raises(RuntimeError) as exc_info:
+            sut_full.set_species_volumes(np.zeros((len(sut_full) + 1, 1)))
+        assert str(exc_info.value) == "volumes must be of shape (n_part, n_spec)"
+
     @staticmethod
     def test_make_dry(sut_minimal):
         # act
@@ -376,12 +641,71 @@ class TestAeroState:
         # assert
         assert False
 
+    @staticmethod
+    def test_particle_view(sut_minimal):
+        # arrange
+        i_part = 20
+        env_state = ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL)
+        env_state.set_temperature(300)
+        env_state.pressure = 1e5
+        particle = sut_minimal.particle(i_part)
+
+        # act
+        view = sut_minimal.particle_view(i_part)
+
+        # assert
+        assert isinstance(view, ppmc.AeroParticleView)
+        assert view.index == i_part
+        assert view.valid
+        assert view.volumes == particle.volumes
+        for attr in ("volume", "dry_volume", "diameter", "dry_diameter", "mass", "id"):
+            assert getattr(view, attr) == getattr(particle, attr)
+        assert view.mobility_diameter(env_state) == particle.mobility_diameter(env_state)
+        assert view.copy().diameter == particle.diameter
+
+    @staticmethod
+    def test_particle_view_outlives_python_reference():
+        # arrange
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_MINIMAL)
+        aero_state = ppmc.AeroState(aero_data, *AERO_STATE_CTOR_ARG_MINIMAL)
+        aero_state.dist_sample(ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_MINIMAL))
+        diameter = aero_state.diameters()[0]
+
+        # act
+        view = aero_state.particle_view(0)
+        del aero_state
+        gc.collect()
+
+        # assert
+        assert view.diameter == diameter
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_particle_view_invalidated(sut_minimal):
+        # arrange
+        view = sut_minimal.particle_view(0)
+
+        # act
+        sut_minimal.remove_particle(len(sut_minimal) - 1)
+
+        # assert
+        assert not view.valid
+        with pytest.raises(RuntimeError):
+            _ = view.mass
+
+    @staticmethod
+    @pytest.mark.parametrize("idx", (-1, 500))
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_particle_view_out_of_range(sut_minimal, idx):
+        with pytest.raises(IndexError):
+            _ = sut_minimal.particle_view(idx)
+
     @staticmethod
     def test_remove_particle(sut_minimal):
         diameters = sut_minimal.diameters()
         sut_minimal.remove_particle(len(sut_minimal) - 1)
 
-        assert diameters[0:-1] == sut_minimal.diameters()
+        np.testing.assert_array_equal(diameters[0:-1], sut_minimal.diameters())
 
     @staticmethod
     def test_zero(sut_minimal):
@@ -36,6 +36,18 @@ class TestBinGrid:
         # assert
         assert size == grid_size
 
+    @staticmethod
+    @pytest.mark.parametrize("grid_type", ("log", "linear"))
+    def test_type(grid_type):
+        # arrange
+        sut = ppmc.BinGrid(10, grid_type, 1, 100)
+
+        # act
+        value = sut.type
+
+        # assert
+        assert value == grid_type
+
     @staticmethod
     def test_bin_edges_len():
         # arrange
@@ -153,6 +165,43 @@ class TestBinGrid:
         # assert
         np.testing.assert_array_almost_equal(data, hist / (bin_edges[1] - bin_edges[0]))
 
+    @staticmethod
+    @pytest.mark.parametrize(
+        "convert",
+        (
+            list,
+            lambda arr: arr.astype(np.float32),
+            lambda arr: np.repeat(arr, 2)[::2],
+        ),
+    )
+    def test_histogram_1d_converted_input(convert):
+        # arrange
+        n_data = 100
+        grid = ppmc.BinGrid(10, "linear", 0, 1000)
+        vals = np.floor(np.random.random(n_data) * 1000)
+        weights = np.ones(n_data)
+
+        # act
+        data = ppmc.histogram_1d(grid, convert(vals), convert(weights))
+
+        # assert
+        np.testing.assert_array_almost_equal(
+            data, ppmc.histogram_1d(grid, vals, weights)
+        )
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_histogram_1d_size_mismatch():
+        # arrange
+        grid = ppmc.BinGrid(10, "linear", 0, 1000)
+
+        # act
+        with pytest.raises(RuntimeError) as excinfo:
+            ppmc.histogram_1d(grid, np.ones(10), np.ones(11))
+
+        # assert
+        assert str(excinfo.value) == "values and weights must be of equal length"
+
     @staticmethod
     def test_histogram_2d_linear_linear():
         # arrange
@@ -236,3 +285,117 @@ class TestBinGrid:
         np.testing.assert_array_almost_equal(
             np.array(data), data_numpy / cell_size, decimal=13
         )
+
+    @staticmethod
+    def test_histogram_2d_ndarray():
+        # arrange
+        x_grid = ppmc.BinGrid(15, "linear", 0, 1000)
+        y_grid = ppmc.BinGrid(12, "linear", 0, 500)
+
+        # act
+        data = ppmc.histogram_2d(x_grid, [100.0], y_grid, [100.0], [1.0])
+
+        # assert
+        assert isinstance(data, np.ndarray)
+        assert data.shape == (len(x_grid), len(y_grid))
+
+    @staticmethod
+    def test_histogram_2d_accumulate():
+        # arrange
+        n_data = 100
+        x_grid = ppmc.BinGrid(15, "linear", 0, 1000)
+        y_grid = ppmc.BinGrid(12, "linear", 0, 500)
+        steps = [
+            (
+                np.random.random(n_data) * 1000,
+                np.random.random(n_data) * 500,
+                np.random.random(n_data),
+            )
+            for _ in range(3)
+        ]
+        out = np.zeros((len(x_grid), len(y_grid)))
+
+        # act
+        for x_vals, y_vals, weights in steps:
+            ppmc.histogram_2d_accumulate(x_grid, x_vals, y_grid, y_vals, weights, out)
+
+        # assert
+        np.testing.assert_array_almost_equal(
+            out,
+            sum(
+                ppmc.histogram_2d(x_grid, x_vals, y_grid, y_vals, weights)
+                for x_vals, y_vals, weights in steps
+            ),
+            decimal=12,
+        )
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_histogram_2d_accumulate_shape_mismatch():
+        # arrange
+        x_grid = ppmc.BinGrid(15, "linear", 0, 1000)
+        y_grid = ppmc.BinGrid(12, "linear", 0, 500)
+        out = np.zeros((12, 15))
+
+        # act
+        with pytest.raises(RuntimeError) as excinfo:
+            ppmc.histogram_2d_accumulate(x_grid, [1.0], y_grid, [1.0], [1.0], out)
+
+        # assert
+        assert (
+            str(excinfo.value)
+            == "out must be of shape (len(x_bin_grid), len(y_bin_grid))"
+        )
+
+    @staticmethod
+    def test_histogram_2d_accumulate_no_conversion():
+        # arrange
+        x_grid = ppmc.BinGrid(15, "linear", 0, 1000)
+        y_grid = ppmc.BinGrid(12, "linear", 0, 500)
+        out = np.zeros((len(x_grid), len(y_grid)), dtype=np.float32)
+
+        # act
+        with pytest.raises(TypeError):
+            ppmc.histogram_2d_accumulate(x_grid, [1.0], y_grid, [1.0], [1.0], out)
+
+        # assert
+        assert not out.any()
+
+    @staticmethod
+    @pytest.mark.parametrize("grid_type", ("linear", "log"))
+    @pytest.mark.parametrize("n_threads", (1, 4, 0))
+    def test_histogram_1d_threads(grid_type, n_threads):
+        # arrange
+        n_data = 300000
+        bin_grid = ppmc.BinGrid(50, grid_type, 1, 1000)
+        values = np.random.random(n_data) * 1200
+        weights = np.random.random(n_data)
+
+        # act
+        data = ppmc.histogram_1d(bin_grid, values, weights, n_threads=n_threads)
+
+        # assert
+        hist, _ = np.histogram(values, bins=bin_grid.edges, weights=weights)
+        widths = np.diff(np.log(bin_grid.edges) if grid_type == "log" else bin_grid.edges)
+        np.testing.assert_allclose(data, hist / widths, rtol=1e-10)
+
+    @staticmethod
+    @pytest.mark.parametrize("n_threads", (1, 4))
+    def test_histogram_2d_threads(n_threads):
+        # arrange
+        n_data = 300000
+        x_grid = ppmc.BinGrid(15, "log", 1, 1000)
+        y_grid = ppmc.BinGrid(12, "linear", 0, 500)
+        x_vals = np.random.random(n_data) * 1000
+        y_vals = np.random.random(n_data) * 500
+        weights = np.random.random(n_data)
+
+        # act
+        data = ppmc.histogram_2d(
+            x_grid, x_vals, y_grid, y_vals, weights, n_threads=n_threads
+        )
+
+        # assert
+        np.testing.assert_allclose(
+            data, ppmc.histogram_2d(x_grid, x_vals, y_grid, y_vals, weights), rtol=1e-10
+        )
@@ -63,6 +63,20 @@ class TestGasData:
         # assert
         assert indices == list(range(len(ctor_arg)))
 
+    @staticmethod
+    @pytest.mark.parametrize(
+        "ctor_arg", (GAS_DATA_CTOR_ARG_MINIMAL, ("SO2", "NO2"), ("A", "B", "C"))
+    )
+    def test_spec_indices(ctor_arg):
+        # arrange
+        sut = ppmc.GasData(ctor_arg)
+
+        # act
+        indices = sut.spec_indices(list(ctor_arg))
+
+        # assert
+        assert list(indices) == list(range(len(ctor_arg)))
+
     @staticmethod
     @pytest.mark.parametrize(
         "ctor_arg", (GAS_DATA_CTOR_ARG_MINIMAL, ("SO2", "NO2"), ("A", "B", "C"))
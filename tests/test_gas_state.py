@@ -7,6 +7,7 @@
 import gc
 import platform
 
+import numpy as np
 import pytest
 
 import PyPartMC as ppmc
@@ -146,3 +147,31 @@ class TestGasState:
 
         # assert
         assert str(excinfo.value) == "Non-empty sequence of mixing ratios expected"
+
+    @staticmethod
+    def test_set_mix_rats_array():
+        # arrange
+        gas_data = ppmc.GasData(("SO2", "NO2", "NO", "CO"))
+        sut = ppmc.GasState(gas_data)
+        values = np.asarray([0.1, 0.2, 0.3, 0.4])
+
+        # act
+        sut.set_mix_rats_array(values)
+
+        # assert
+        assert sut.mix_rats == list(values)
+        assert sut.mix_rat("CO") == values[3]
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_set_mix_rats_array_wrong_length():
+        # arrange
+        gas_data = ppmc.GasData(("SO2", "NO2"))
+        sut = ppmc.GasState(gas_data)
+
+        # act
+        with pytest.raises(RuntimeError) as excinfo:
+            sut.set_mix_rats_array(np.zeros(3))
+
+        # assert
+        assert str(excinfo.value) == "mixing ratios must be of length n_spec"
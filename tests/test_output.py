@@ -5,8 +5,10 @@
 ####################################################################################################
 
 import os
+import platform
 
 import numpy as np
+import pytest
 
 import PyPartMC as ppmc
 
@@ -92,7 +94,7 @@ class TestOutput:
             photolysis,
         )
 
-        assert aero_state.num_concs != num_concs
+        assert not np.array_equal(aero_state.num_concs, num_concs)
 
         aero_data, aero_state, gas_data, gas_state, env_state = ppmc.input_state(
             str(filename) + "_0001_00000001.nc"
@@ -173,3 +175,350 @@ class TestOutput:
             np.sum(np.array(aero_binned.num_conc) * np.array(bin_grid.widths)),
             aero_dist.num_conc,
         )
+
+    @staticmethod
+    def _run_part_with_output(prefix, **run_part_opt_args):
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL)
+        gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
+        gas_state = ppmc.GasState(gas_data)
+        scenario = ppmc.Scenario(gas_data, aero_data, SCENARIO_CTOR_ARG_SIMULATION)
+        env_state = ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL)
+        scenario.init_env_state(env_state, 0.0)
+        run_part_opt = ppmc.RunPartOpt(
+            {
+                **RUN_PART_OPT_CTOR_ARG_SIMULATION,
+                "output_prefix": str(prefix),
+                **run_part_opt_args,
+            }
+        )
+        aero_dist = ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_COAGULATION)
+        aero_state = ppmc.AeroState(aero_data, 100, "nummass_source")
+        aero_state.dist_sample(aero_dist, 1.0, 0.0, False, False)
+        ppmc.run_part(
+            scenario,
+            env_state,
+            aero_data,
+            aero_state,
+            gas_data,
+            gas_state,
+            run_part_opt,
+            ppmc.CampCore(),
+            ppmc.Photolysis(),
+        )
+
+    @staticmethod
+    def test_output_series(tmp_path):
+        # arrange
+        prefix = tmp_path / "test"
+        TestOutput._run_part_with_output(prefix)
+
+        # act
+        series = ppmc.OutputSeries(str(prefix))
+        states = list(series)
+
+        # assert
+        assert len(series) == len(states) > 0
+        assert series.filenames[0].endswith("test_0001_00000001.nc")
+        for aero_data, aero_state, gas_data, gas_state, env_state in states:
+            assert aero_data is states[0][0]
+            assert gas_data is states[0][2]
+            assert len(aero_state) > 0
+            assert len(gas_state) == len(gas_data)
+            assert env_state.temp > 0
+
+        _, aero_state, _, gas_state, _ = ppmc.input_state(series.filenames[0])
+        np.testing.assert_allclose(states[0][1].num_concs, aero_state.num_concs)
+        np.testing.assert_array_equal(states[0][3].mix_rats, gas_state.mix_rats)
+
+    @staticmethod
+    def test_output_series_components(tmp_path):
+        # arrange
+        prefix = tmp_path / "test"
+        TestOutput._run_part_with_output(prefix)
+
+        # act
+        _, aero_state, _, gas_state, env_state = ppmc.OutputSeries(
+            str(prefix), components=["aero_state"]
+        )[-1]
+
+        # assert
+        assert len(aero_state) > 0
+        assert gas_state is None
+        assert env_state is None
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_output_series_unknown_component(tmp_path):
+        # arrange
+        prefix = tmp_path / "test"
+        TestOutput._run_part_with_output(prefix)
+
+        # act
+        with pytest.raises(RuntimeError) as exc_info:
+            ppmc.OutputSeries(str(prefix), components=["aero_data"])
+
+        # assert
+        assert str(exc_info.value).startswith("unknown component 'aero_data'")
+
+    @staticmethod
+    def test_output_file_columns(tmp_path):
+        # arrange
+        prefix = tmp_path / "test"
+        TestOutput._run_part_with_output(prefix)
+        filename = str(prefix) + "_0001_00000001.nc"
+        aero_data, aero_state, *_ = ppmc.input_state(filename)
+
+        # act
+        output_file = ppmc.OutputFile(filename)
+        num_conc = output_file["aero_num_conc"]
+        particle_mass = output_file["aero_particle_mass"]
+        loaded_before = particle_mass.loaded
+
+        # assert
+        assert "aero_particle_mass" in output_file.variables
+        assert not loaded_before
+        assert particle_mass.shape == [len(aero_data), len(aero_state)]
+        assert particle_mass.values.shape == (len(aero_data), len(aero_state))
+        assert particle_mass.loaded
+        assert not output_file["aero_id"].loaded
+        assert output_file["aero_num_conc"] is num_conc
+        np.testing.assert_allclose(num_conc.values, aero_state.num_concs)
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_output_file_unknown_variable(tmp_path):
+        # arrange
+        prefix = tmp_path / "test"
+        TestOutput._run_part_with_output(prefix)
+        output_file = ppmc.OutputFile(str(prefix) + "_0001_00000001.nc")
+
+        # act
+        with pytest.raises(RuntimeError) as exc_info:
+            _ = output_file["aero_nonexistent"]
+
+        # assert
+        assert str(exc_info.value).startswith("unknown variable 'aero_nonexistent'")
+
+    @staticmethod
+    def test_output_file_integer_column(tmp_path):
+        # arrange
+        prefix = tmp_path / "test"
+        TestOutput._run_part_with_output(prefix)
+        filename = str(prefix) + "_0001_00000001.nc"
+        _, aero_state, *_ = ppmc.input_state(filename)
+
+        # act
+        ids = ppmc.OutputFile(filename)["aero_id"].values
+
+        # assert
+        assert ids.dtype == np.int64
+        np.testing.assert_array_equal(ids, aero_state.ids)
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_output_file_changed_shape(tmp_path):
+        # arrange
+        states = TestOutput._sampled_states()
+        ppmc.output_state(str(tmp_path / "test"), *states)
+        output_file = ppmc.OutputFile(str(tmp_path / "test") + "_0001_00000001.nc")
+        states[1].remove_particle(0)
+        ppmc.output_state(str(tmp_path / "test"), *states)
+
+        # act
+        with pytest.raises(RuntimeError) as exc_info:
+            _ = output_file["aero_particle_mass"].values
+
+        # assert
+        assert "changed its shape" in str(exc_info.value)
+
+    @staticmethod
+    def test_async_output_writer(tmp_path):
+        # arrange
+        filename = tmp_path / "test"
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL)
+        gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
+        gas_state = ppmc.GasState(gas_data)
+        env_state = ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL)
+        ppmc.Scenario(gas_data, aero_data, SCENARIO_CTOR_ARG_SIMULATION).init_env_state(
+            env_state, 0.0
+        )
+        aero_dist = ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_COAGULATION)
+        aero_state = ppmc.AeroState(aero_data, 100, "nummass_source")
+        aero_state.dist_sample(aero_dist, 1.0, 0.0, False, False)
+        num_concs = aero_state.num_concs
+        writer = ppmc.AsyncOutputWriter()
+
+        # act
+        for index in (1, 2, 3):
+            writer.output_state(
+                str(filename),
+                aero_data,
+                aero_state,
+                gas_data,
+                gas_state,
+                env_state,
+                index=index,
+            )
+            aero_state.zero()
+            aero_state.dist_sample(aero_dist, 1.0, 0.0, False, False)
+        writer.flush()
+
+        # assert
+        assert writer.pending == 0
+        for index in (1, 2, 3):
+            assert os.path.exists(f"{filename}_0001_{index:08d}.nc")
+        _, first, *_ = ppmc.input_state(str(filename) + "_0001_00000001.nc")
+        np.testing.assert_allclose(first.num_concs, num_concs)
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_async_output_writer_data_mismatch(tmp_path):
+        # arrange
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL)
+        gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
+        aero_state = ppmc.AeroState(
+            ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL), 100, "nummass_source"
+        )
+        writer = ppmc.AsyncOutputWriter()
+
+        # act
+        with pytest.raises(RuntimeError) as excinfo:
+            writer.output_state(
+                str(tmp_path / "test"),
+                aero_data,
+                aero_state,
+                gas_data,
+                ppmc.GasState(gas_data),
+                ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL),
+            )
+
+        # assert
+        assert (
+            str(excinfo.value)
+            == "aero_state and gas_state must use the given aero_data and gas_data"
+        )
+        assert writer.pending == 0
+
+    @staticmethod
+    def test_output_netcdf_layout(tmp_path):
+        # arrange
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL)
+        gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
+        gas_state = ppmc.GasState(gas_data)
+        env_state = ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL)
+        ppmc.Scenario(gas_data, aero_data, SCENARIO_CTOR_ARG_SIMULATION).init_env_state(
+            env_state, 0.0
+        )
+        aero_dist = ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_COAGULATION)
+        aero_state = ppmc.AeroState(aero_data, 100, "nummass_source")
+        aero_state.dist_sample(aero_dist, 1.0, 0.0, False, False)
+        states = (aero_data, aero_state, gas_data, gas_state, env_state)
+
+        # act
+        ppmc.output_state(str(tmp_path / "plain"), *states)
+        ppmc.output_state(str(tmp_path / "chunked"), *states, chunk_size=16, shuffle=True)
+
+        # assert
+        plain = ppmc.OutputFile(str(tmp_path / "plain") + "_0001_00000001.nc")
+        chunked = ppmc.OutputFile(str(tmp_path / "chunked") + "_0001_00000001.nc")
+        assert chunked.variables == plain.variables
+        for name in ("aero_particle_mass", "aero_num_conc", "aero_id"):
+            np.testing.assert_array_equal(chunked[name].values, plain[name].values)
+
+    @staticmethod
+    def _sampled_states():
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL)
+        gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
+        env_state = ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL)
+        ppmc.Scenario(gas_data, aero_data, SCENARIO_CTOR_ARG_SIMULATION).init_env_state(
+            env_state, 0.0
+        )
+        aero_state = ppmc.AeroState(aero_data, 1000, "nummass_source")
+        aero_state.dist_sample(
+            ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_COAGULATION), 1.0, 0.0, False, False
+        )
+        return aero_data, aero_state, gas_data, ppmc.GasState(gas_data), env_state
+
+    @staticmethod
+    def test_output_netcdf_chunking(tmp_path):
+        # arrange
+        netCDF4 = pytest.importorskip("netCDF4")  # pylint: disable=invalid-name
+        states = TestOutput._sampled_states()
+        chunk_size = 16
+
+        # act
+        ppmc.output_state(str(tmp_path / "test"), *states, chunk_size=chunk_size, shuffle=True)
+
+        # assert
+        with netCDF4.Dataset(str(tmp_path / "test") + "_0001_00000001.nc") as dataset:
+            variable = dataset.variables["aero_num_conc"]
+            assert variable.chunking() == [min(chunk_size, len(states[1]))]
+            assert variable.filters()["shuffle"]
+            assert not variable.filters()["zlib"]
+
+    @staticmethod
+    def test_output_netcdf_deflate(tmp_path):
+        # arrange
+        states = TestOutput._sampled_states()
+        plain = str(tmp_path / "plain") + "_0001_00000001.nc"
+        deflated = str(tmp_path / "deflated") + "_0001_00000001.nc"
+        ppmc.output_state(str(tmp_path / "plain"), *states)
+
+        # act
+        ppmc.output_state(str(tmp_path / "deflated"), *states, deflate_level=9, shuffle=True)
+
+        # assert
+        assert os.path.getsize(deflated) < os.path.getsize(plain)
+        np.testing.assert_array_equal(
+            ppmc.OutputFile(deflated)["aero_particle_mass"].values,
+            ppmc.OutputFile(plain)["aero_particle_mass"].values,
+        )
+
+    @staticmethod
+    def test_run_part_output_layout_own_files_only(tmp_path):
+        # arrange
+        prefix = tmp_path / "test"
+        other = tmp_path / "test_0001_99999999.nc"
+        other.write_bytes(b"not a netCDF file")
+
+        # act
+        TestOutput._run_part_with_output(prefix, output_chunk_size=64)
+
+        # assert
+        assert other.read_bytes() == b"not a netCDF file"
+
+    @staticmethod
+    def test_run_part_output_layout(tmp_path):
+        # arrange
+        prefix = tmp_path / "test"
+        run_part_opt_args = {"output_chunk_size": 64, "output_shuffle": True}
+
+        # act
+        TestOutput._run_part_with_output(prefix, **run_part_opt_args)
+
+        # assert
+        series = ppmc.OutputSeries(str(prefix))
+        assert len(series) > 1
+        _, aero_state, *_ = series[-1]
+        assert len(aero_state) > 0
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_output_netcdf_layout_invalid_deflate_level(tmp_path):
+        # arrange
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL)
+        gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
+        states = (
+            aero_data,
+            ppmc.AeroState(aero_data, 10, "nummass_source"),
+            gas_data,
+            ppmc.GasState(gas_data),
+            ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL),
+        )
+
+        # act
+        with pytest.raises(RuntimeError) as exc_info:
+            ppmc.output_state(str(tmp_path / "test"), *states, deflate_level=10)
+
+        # assert
+        assert str(exc_info.value) == "deflate_level must be within [0, 9]"
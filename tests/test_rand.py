@@ -4,10 +4,26 @@
 # Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
 ####################################################################################################
 
+import platform
+
+import numpy as np
 import pytest
 
 import PyPartMC as ppmc
 
+from .test_aero_data import AERO_DATA_CTOR_ARG_MINIMAL
+from .test_aero_dist import AERO_DIST_CTOR_ARG_MINIMAL
+from .test_aero_state import AERO_STATE_CTOR_ARG_MINIMAL
+
+
+def sample_diameters(random_state):
+    aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_MINIMAL)
+    aero_dist = ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_MINIMAL)
+    aero_state = ppmc.AeroState(aero_data, *AERO_STATE_CTOR_ARG_MINIMAL)
+    aero_state.random_state = random_state
+    aero_state.dist_sample(aero_dist)
+    return np.asarray(aero_state.diameters())
+
 
 @pytest.mark.order(-1)
 @pytest.mark.parametrize(
@@ -30,3 +46,149 @@ def test_set_rand_seed(seeds):
     # assert
     for value in values[1:]:
         assert value == values[0]
+
+
+@pytest.mark.parametrize("seed", (44, 0))
+def test_random_state_seed(seed):
+    # act
+    sut = ppmc.RandomState(seed)
+
+    # assert
+    assert sut.seed > 0
+    if seed != 0:
+        assert sut.seed == ppmc.RandomState(seed, stream=0).seed
+        assert sut.seed != ppmc.RandomState(seed, stream=1).seed
+
+
+def test_random_state_reproducible():
+    # act
+    first = sample_diameters(ppmc.RandomState(44))
+    ppmc.rand_normal(0, 1)
+    second = sample_diameters(ppmc.RandomState(44))
+
+    # assert
+    np.testing.assert_array_equal(first, second)
+
+
+def test_random_state_streams_differ():
+    # act
+    first = sample_diameters(ppmc.RandomState(44, stream=0))
+    second = sample_diameters(ppmc.RandomState(44, stream=1))
+
+    # assert
+    assert not np.array_equal(first, second)
+
+
+def test_random_state_leaves_thread_state():
+    # arrange
+    ppmc.rand_init(44)
+    expected = ppmc.rand_normal(0, 1)
+
+    # act
+    ppmc.rand_init(44)
+    sample_diameters(ppmc.RandomState(45))
+    actual = ppmc.rand_normal(0, 1)
+
+    # assert
+    assert actual == expected
+
+
+def test_random_state_advances():
+    # arrange
+    random_state = ppmc.RandomState(44)
+
+    # act
+    first = sample_diameters(random_state)
+    second = sample_diameters(random_state)
+
+    # assert
+    assert not np.array_equal(first, second)
+
+
+def test_rand_normal_array():
+    # arrange
+    ppmc.rand_init(44)
+    mean, stddev, n = 2.0, 3.0, 100001
+
+    # act
+    sut = ppmc.rand_normal(mean, stddev, n)
+
+    # assert
+    assert isinstance(sut, np.ndarray)
+    assert sut.shape == (n,)
+    assert sut.dtype == np.float64
+    assert abs(np.mean(sut) - mean) < 5 * stddev / np.sqrt(n)
+    assert abs(np.std(sut) / stddev - 1) < 0.02
+
+
+def test_rand_uniform():
+    # arrange
+    ppmc.rand_init(44)
+    n = 100000
+
+    # act
+    sut = ppmc.rand_uniform(n)
+
+    # assert
+    assert sut.shape == (n,)
+    assert np.all(sut >= 0)
+    assert np.all(sut < 1)
+    assert abs(np.mean(sut) - 0.5) < 0.01
+
+
+def test_rand_poisson():
+    # arrange
+    ppmc.rand_init(44)
+    mean, n = 4.5, 100000
+
+    # act
+    sut = ppmc.rand_poisson(mean, n)
+
+    # assert
+    assert sut.shape == (n,)
+    assert np.issubdtype(sut.dtype, np.integer)
+    assert np.all(sut >= 0)
+    assert abs(np.mean(sut) - mean) < 0.05
+
+
+def test_rand_binomial():
+    # arrange
+    ppmc.rand_init(44)
+    n, p, size = 20, 0.25, 100000
+
+    # act
+    sut = ppmc.rand_binomial(n, p, size)
+
+    # assert
+    assert sut.shape == (size,)
+    assert np.all(sut >= 0)
+    assert np.all(sut <= n)
+    assert abs(np.mean(sut) - n * p) < 0.05
+
+
+@pytest.mark.parametrize(
+    "call",
+    (
+        lambda random_state: ppmc.rand_normal(0, 1, 10, random_state),
+        lambda random_state: ppmc.rand_uniform(10, random_state),
+        lambda random_state: ppmc.rand_poisson(1, 10, random_state),
+        lambda random_state: ppmc.rand_binomial(10, 0.5, 10, random_state),
+    ),
+)
+def test_bulk_rand_random_state(call):
+    # act
+    first = call(ppmc.RandomState(44))
+    second = call(ppmc.RandomState(44))
+
+    # assert
+    np.testing.assert_array_equal(first, second)
+
+
+@pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+def test_bulk_rand_fails_on_negative_size():
+    # act
+    with pytest.raises(RuntimeError) as exc_info:
+        ppmc.rand_uniform(-1)
+
+    # assert
+    assert str(exc_info.value) == "size must be non-negative"
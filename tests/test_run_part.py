@@ -5,6 +5,7 @@
 ####################################################################################################
 
 import platform
+from concurrent.futures import ThreadPoolExecutor
 
 import numpy as np
 import pytest
@@ -12,7 +13,7 @@ import pytest
 import PyPartMC as ppmc
 
 from .test_aero_data import AERO_DATA_CTOR_ARG_FULL, AERO_DATA_CTOR_ARG_MINIMAL
-from .test_aero_dist import AERO_DIST_CTOR_ARG_FULL
+from .test_aero_dist import AERO_DIST_CTOR_ARG_FULL, AERO_DIST_CTOR_ARG_MINIMAL
 from .test_aero_state import AERO_STATE_CTOR_ARG_MINIMAL
 from .test_env_state import ENV_STATE_CTOR_ARG_HIGH_RH, ENV_STATE_CTOR_ARG_MINIMAL
 from .test_gas_data import GAS_DATA_CTOR_ARG_MINIMAL
@@ -20,17 +21,19 @@ from .test_run_part_opt import RUN_PART_OPT_CTOR_ARG_SIMULATION
 from .test_scenario import SCENARIO_CTOR_ARG_MINIMAL
 
 
-@pytest.fixture(name="common_args")
-def common_args_fixture(tmp_path):
+def make_common_args(filename, **run_part_opt_args):
     aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_MINIMAL)
     gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
     gas_state = ppmc.GasState(gas_data)
     scenario = ppmc.Scenario(gas_data, aero_data, SCENARIO_CTOR_ARG_MINIMAL)
     env_state = ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL)
     scenario.init_env_state(env_state, 0.0)
-    filename = tmp_path / "test"
     run_part_opt = ppmc.RunPartOpt(
-        {**RUN_PART_OPT_CTOR_ARG_SIMULATION, "output_prefix": str(filename)}
+        {
+            **RUN_PART_OPT_CTOR_ARG_SIMULATION,
+            "output_prefix": str(filename),
+            **run_part_opt_args,
+        }
     )
     return (
         scenario,
@@ -45,6 +48,11 @@ def common_args_fixture(tmp_path):
     )
 
 
+@pytest.fixture(name="common_args")
+def common_args_fixture(tmp_path):
+    return make_common_args(tmp_path / "test")
+
+
 class TestRunPart:
     @staticmethod
     def test_run_part(common_args):
@@ -81,6 +89,157 @@ class TestRunPart:
         assert last_progress_time == 0.0
         assert i_output == 2
 
+    @staticmethod
+    @pytest.mark.parametrize("t_output", (0, RUN_PART_OPT_CTOR_ARG_SIMULATION["t_output"]))
+    def test_run_part_concurrent(tmp_path, t_output):
+        # arrange
+        n_threads = 4
+        members = [
+            make_common_args(tmp_path / f"test_{i}", t_output=t_output)
+            for i in range(n_threads)
+        ]
+
+        # act
+        with ThreadPoolExecutor(max_workers=n_threads) as executor:
+            list(executor.map(lambda args: ppmc.run_part(*args), members))
+
+        # assert
+        for i, args in enumerate(members):
+            assert args[1].elapsed_time == RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+            assert bool(list(tmp_path.glob(f"test_{i}_*.nc"))) == bool(t_output)
+
+    @staticmethod
+    def make_ensemble(tmp_path, n_members, t_output=0):
+        aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_MINIMAL)
+        gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
+        scenario = ppmc.Scenario(gas_data, aero_data, SCENARIO_CTOR_ARG_MINIMAL)
+        env_states = [ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL) for _ in range(n_members)]
+        for env_state in env_states:
+            scenario.init_env_state(env_state, 0.0)
+        aero_states = [
+            ppmc.AeroState(aero_data, *AERO_STATE_CTOR_ARG_MINIMAL) for _ in range(n_members)
+        ]
+        for aero_state in aero_states:
+            ppmc.rand_init(1)
+            aero_state.dist_sample(
+                ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_MINIMAL), 1.0, 0.0, False, False
+            )
+        return {
+            "scenario": scenario,
+            "env_states": env_states,
+            "aero_data": aero_data,
+            "aero_states": aero_states,
+            "gas_data": gas_data,
+            "gas_states": [ppmc.GasState(gas_data) for _ in range(n_members)],
+            "run_part_opt": ppmc.RunPartOpt(
+                {
+                    **RUN_PART_OPT_CTOR_ARG_SIMULATION,
+                    "output_prefix": str(tmp_path / "test"),
+                    "t_output": t_output,
+                }
+            ),
+            "camp_core": ppmc.CampCore(),
+            "photolysis": ppmc.Photolysis(),
+        }
+
+    @staticmethod
+    @pytest.mark.parametrize("n_threads", (0, 1, 3))
+    def test_run_part_ensemble(tmp_path, n_threads):
+        # arrange
+        n_members = 5
+        args = TestRunPart.make_ensemble(tmp_path, n_members)
+
+        # act
+        seeds = ppmc.run_part_ensemble(**args, n_threads=n_threads, seed=44)
+
+        # assert
+        assert len(seeds) == n_members
+        assert len(set(seeds)) == n_members
+        assert seeds == ppmc.run_part_ensemble(
+            **TestRunPart.make_ensemble(tmp_path, n_members), seed=44
+        )
+        for env_state in args["env_states"]:
+            assert env_state.elapsed_time == RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+
+    @staticmethod
+    def test_run_part_ensemble_member_reproducible(tmp_path):
+        # arrange
+        i_member = 1
+        ensemble = TestRunPart.make_ensemble(tmp_path, 3)
+        seeds = ppmc.run_part_ensemble(**ensemble, n_threads=3, seed=44)
+        member = TestRunPart.make_ensemble(tmp_path, 1)
+
+        # act
+        ppmc.rand_init(seeds[i_member])
+        ppmc.run_part(
+            member["scenario"],
+            member["env_states"][0],
+            member["aero_data"],
+            member["aero_states"][0],
+            member["gas_data"],
+            member["gas_states"][0],
+            member["run_part_opt"],
+            member["camp_core"],
+            member["photolysis"],
+        )
+
+        # assert (particle IDs come from a process-wide counter shared with the other members,
+        # hence are not compared)
+        expected = ensemble["aero_states"][i_member]
+        actual = member["aero_states"][0]
+        assert len(actual) == len(expected)
+        np.testing.assert_array_equal(actual.num_concs, expected.num_concs)
+        np.testing.assert_array_equal(actual.diameters(), expected.diameters())
+
+    @staticmethod
+    def test_run_part_ensemble_unique_ids(tmp_path):
+        # arrange
+        n_members = 4
+        args = TestRunPart.make_ensemble(tmp_path, n_members)
+
+        # act
+        ppmc.run_part_ensemble(**args, n_threads=n_members, seed=44)
+
+        # assert
+        ids = np.concatenate([aero_state.ids for aero_state in args["aero_states"]])
+        assert len(np.unique(ids)) == len(ids)
+
+    @staticmethod
+    def test_run_part_ensemble_output(tmp_path):
+        # arrange
+        n_members = 3
+        args = TestRunPart.make_ensemble(
+            tmp_path, n_members, t_output=RUN_PART_OPT_CTOR_ARG_SIMULATION["t_output"]
+        )
+        n_outputs = 1 + int(
+            RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+            / RUN_PART_OPT_CTOR_ARG_SIMULATION["t_output"]
+        )
+
+        # act
+        ppmc.run_part_ensemble(**args, n_threads=n_members, seed=44)
+
+        # assert
+        for i_repeat in range(1, n_members + 1):
+            assert len(list(tmp_path.glob(f"test_{i_repeat:04d}_*.nc"))) == n_outputs
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_run_part_ensemble_length_mismatch(tmp_path):
+        # arrange
+        args = TestRunPart.make_ensemble(tmp_path, 2)
+        args["gas_states"] = args["gas_states"][:1]
+
+        # act
+        with pytest.raises(RuntimeError) as excinfo:
+            ppmc.run_part_ensemble(**args)
+
+        # assert
+        assert (
+            str(excinfo.value)
+            == "env_states, aero_states and gas_states must be of equal length"
+        )
+
     @staticmethod
     def test_run_part_do_condensation(common_args, tmp_path):
         filename = tmp_path / "test"
@@ -162,3 +321,175 @@ class TestRunPart:
             str(excinfo.value)
             == "allow halving/doubling flags set differently then while sampling"
         )
+
+    @staticmethod
+    def test_run_part_output_sink(tmp_path):
+        # arrange
+        args = make_common_args(tmp_path / "test")
+        n_output = int(
+            RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+            / RUN_PART_OPT_CTOR_ARG_SIMULATION["t_output"]
+        )
+        sink = ppmc.OutputSink(capacity=3, fields=["num_concs", "ids"])
+        args[6].output_sink = sink
+
+        # act
+        ppmc.run_part(*args)
+
+        # assert
+        assert not list(tmp_path.glob("*.nc"))
+        assert args[1].elapsed_time == RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+        assert [snapshot.index for snapshot in sink] == [
+            n_output - 1,
+            n_output,
+            n_output + 1,
+        ]
+        assert sink[-1].time == RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+        np.testing.assert_array_equal(sink[-1].aero["num_concs"], args[3].num_concs)
+        np.testing.assert_array_equal(sink[-1].aero["ids"], args[3].ids)
+        np.testing.assert_array_equal(sink[-1].mix_rats, args[5].mix_rats)
+
+    @staticmethod
+    def test_run_part_timeblock_output_callback(tmp_path):
+        # arrange
+        args = make_common_args(tmp_path / "test")
+        num_times = int(
+            RUN_PART_OPT_CTOR_ARG_SIMULATION["t_output"]
+            / RUN_PART_OPT_CTOR_ARG_SIMULATION["del_t"]
+        )
+        snapshots = []
+        sink = ppmc.OutputSink(callback=snapshots.append)
+        args[6].output_sink = sink
+
+        # act
+        last_output_time, _, i_output = ppmc.run_part_timeblock(
+            *args, 1, num_times, 0, 0, 0, 1
+        )
+
+        # assert
+        assert not list(tmp_path.glob("*.nc"))
+        assert len(sink) == 0
+        assert last_output_time == RUN_PART_OPT_CTOR_ARG_SIMULATION["t_output"]
+        assert i_output == 2
+        assert [snapshot.index for snapshot in snapshots] == [1, 2]
+        assert snapshots[0].time == 0
+        assert len(snapshots[1].aero["masses"]) == len(args[3])
+
+    @staticmethod
+    def test_run_part_async_writer(tmp_path):
+        # arrange
+        args = make_common_args(tmp_path / "test")
+        writer = ppmc.AsyncOutputWriter()
+        args[6].async_writer = writer
+        n_output = 1 + int(
+            RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+            / RUN_PART_OPT_CTOR_ARG_SIMULATION["t_output"]
+        )
+
+        # act
+        ppmc.run_part(*args)
+        writer.flush()
+
+        # assert
+        filenames = ppmc.OutputSeries(str(tmp_path / "test")).filenames
+        assert len(filenames) == n_output
+        *_, env_state = ppmc.input_state(filenames[-1])
+        assert env_state.elapsed_time == RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+
+    @staticmethod
+    def test_run_part_async_writer_removals(tmp_path):
+        # arrange
+        def run(prefix, async_writer):
+            args = make_common_args(prefix, rand_init=44, record_removals=True)
+            args[3].dist_sample(
+                ppmc.AeroDist(args[2], AERO_DIST_CTOR_ARG_MINIMAL), 1.0, 0.0, False, False
+            )
+            args[6].async_writer = async_writer
+            ppmc.run_part(*args)
+            if async_writer is not None:
+                async_writer.flush()
+            return ppmc.OutputSeries(str(prefix)).filenames
+
+        def removals(filenames):
+            # particle IDs come from a process-wide counter, hence relative to the first one
+            first_id = ppmc.OutputFile(filenames[0])["aero_id"].values.min()
+            result = []
+            for filename in filenames:
+                output_file = ppmc.OutputFile(filename)
+                action = output_file["aero_removed_action"].values
+                removed_id = output_file["aero_removed_id"].values
+                result.append((action, np.where(action != 0, removed_id - first_id, 0)))
+            return result
+
+        # act
+        expected = removals(run(tmp_path / "sync", None))
+        actual = removals(run(tmp_path / "async", ppmc.AsyncOutputWriter()))
+
+        # assert
+        assert len(actual) == len(expected)
+        assert any((action != 0).any() for action, _ in expected)
+        for (actual_action, actual_id), (expected_action, expected_id) in zip(actual, expected):
+            np.testing.assert_array_equal(actual_action, expected_action)
+            np.testing.assert_array_equal(actual_id, expected_id)
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_run_part_async_writer_with_output_sink(tmp_path):
+        # arrange
+        args = make_common_args(tmp_path / "test")
+        args[6].async_writer = ppmc.AsyncOutputWriter()
+        args[6].output_sink = ppmc.OutputSink()
+
+        # act
+        with pytest.raises(RuntimeError) as excinfo:
+            ppmc.run_part(*args)
+
+        # assert
+        assert str(excinfo.value) == "output_sink and async_writer cannot be both set"
+
+    @staticmethod
+    def test_run_part_output_callback_outside_random_state(tmp_path):
+        # arrange
+        def run(callback):
+            args = make_common_args(tmp_path / "test")
+            args[3].random_state = ppmc.RandomState(44)
+            args[3].dist_sample(
+                ppmc.AeroDist(args[2], AERO_DIST_CTOR_ARG_MINIMAL), 1.0, 0.0, False, False
+            )
+            args[6].output_sink = ppmc.OutputSink(callback=callback)
+            ppmc.run_part(*args)
+            return args[3]
+
+        # act
+        expected = run(lambda _: None)
+        actual = run(lambda _: ppmc.rand_uniform(10))
+
+        # assert
+        np.testing.assert_array_equal(actual.num_concs, expected.num_concs)
+        np.testing.assert_array_equal(actual.diameters(), expected.diameters())
+
+    @staticmethod
+    def test_run_part_random_state_reassigned_while_running(tmp_path):
+        # arrange
+        args = make_common_args(tmp_path / "test")
+        args[3].random_state = ppmc.RandomState(44)
+
+        # act
+        with ThreadPoolExecutor(max_workers=1) as executor:
+            future = executor.submit(ppmc.run_part, *args)
+            while not future.done():
+                args[3].random_state = ppmc.RandomState(44)
+            future.result()
+
+        # assert
+        assert args[1].elapsed_time == RUN_PART_OPT_CTOR_ARG_SIMULATION["t_max"]
+
+    @staticmethod
+    @pytest.mark.skipif(platform.machine() == "arm64", reason="TODO #348")
+    def test_output_sink_unknown_field():
+        # act
+        with pytest.raises(RuntimeError) as excinfo:
+            ppmc.OutputSink(fields=["sizes"])
+
+        # assert
+        assert str(excinfo.value).startswith("unknown field 'sizes'")
@@ -0,0 +1,92 @@
+####################################################################################################
+# This file is a part of PyPartMC licensed under the GNU General Public License v3 (LICENSE file)  #
+# Copyright (C) 2025 University of Illinois Urbana-Champaign                                       #
+# Authors: https://github.com/open-atmos/PyPartMC/graphs/contributors                              #
+####################################################################################################
+
+import pickle
+
+import numpy as np
+import pytest
+
+import PyPartMC as ppmc
+
+from .test_aero_data import AERO_DATA_CTOR_ARG_FULL
+from .test_aero_dist import AERO_DIST_CTOR_ARG_COAGULATION
+from .test_env_state import ENV_STATE_CTOR_ARG_MINIMAL
+from .test_gas_data import GAS_DATA_CTOR_ARG_MINIMAL
+from .test_scenario import SCENARIO_CTOR_ARG_SIMULATION
+
+
+@pytest.fixture(name="states")
+def states_fixture():
+    aero_data = ppmc.AeroData(AERO_DATA_CTOR_ARG_FULL)
+    gas_data = ppmc.GasData(GAS_DATA_CTOR_ARG_MINIMAL)
+    gas_state = ppmc.GasState(gas_data)
+    scenario = ppmc.Scenario(gas_data, aero_data, SCENARIO_CTOR_ARG_SIMULATION)
+    env_state = ppmc.EnvState(ENV_STATE_CTOR_ARG_MINIMAL)
+    scenario.init_env_state(env_state, 0.0)
+    aero_state = ppmc.AeroState(aero_data, 100, "nummass_source")
+    aero_state.dist_sample(ppmc.AeroDist(aero_data, AERO_DIST_CTOR_ARG_COAGULATION))
+    return aero_state, gas_state, env_state
+
+
+def assert_same_states(actual, expected):
+    np.testing.assert_array_equal(actual[0].ids, expected[0].ids)
+    np.testing.assert_allclose(actual[0].num_concs, expected[0].num_concs)
+    np.testing.assert_allclose(
+        actual[0].species_volumes(), expected[0].species_volumes()
+    )
+    np.testing.assert_allclose(actual[1].mix_rats, expected[1].mix_rats)
+    assert actual[2].temp == expected[2].temp
+    assert actual[2].elapsed_time == expected[2].elapsed_time
+
+
+class TestSnapshot:
+    @staticmethod
+    def test_snapshot_restore(states):
+        # arrange
+        snapshot = ppmc.snapshot(*states)
+
+        # act
+        restored = snapshot.restore()
+
+        # assert
+        assert len(snapshot) == len(snapshot.data) > 0
+        assert_same_states(restored, states)
+
+    @staticmethod
+    def test_restore_function(states):
+        # act
+        restored = ppmc.restore(ppmc.snapshot(*states))
+
+        # assert
+        assert_same_states(restored, states)
+
+    @staticmethod
+    def test_restored_states_are_independent(states):
+        # arrange
+        snapshot = ppmc.StateSnapshot(*states)
+        num_concs = states[0].num_concs
+
+        # act
+        branch = snapshot.restore()
+        branch[0].zero()
+
+        # assert
+        assert len(branch[0]) == 0
+        np.testing.assert_allclose(snapshot.restore()[0].num_concs, num_concs)
+
+    @staticmethod
+    def test_pickle(states):
+        # arrange
+        snapshot = ppmc.snapshot(*states)
+
+        # act
+        unpickled = pickle.loads(pickle.dumps(snapshot))
+
+        # assert
+        assert unpickled.data == snapshot.data
+        assert unpickled.aero_data.species == snapshot.aero_data.species
+        assert unpickled.gas_data.species == snapshot.gas_data.species
+        assert_same_states(unpickled.restore(), states)
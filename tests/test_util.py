@@ -5,6 +5,7 @@
 ####################################################################################################
 
 import numpy as np
+import pytest
 
 import PyPartMC as ppmc
 
@@ -68,3 +69,35 @@ class TestUtil:
 
         # assert
         assert rad == arg / 2
+
+    @staticmethod
+    @pytest.mark.parametrize(
+        "fun", ("sphere_vol2rad", "rad2diam", "sphere_rad2vol", "diam2rad")
+    )
+    @pytest.mark.parametrize("shape", ((5,), (2, 3)))
+    def test_array_conversions_match_scalar(fun, shape):
+        # arrange
+        args = np.linspace(1e-20, 1e-6, np.prod(shape)).reshape(shape)
+
+        # act
+        values = getattr(ppmc, fun)(args)
+
+        # assert
+        assert isinstance(values, np.ndarray)
+        assert values.shape == shape
+        np.testing.assert_allclose(
+            values.ravel(),
+            [getattr(ppmc, fun)(arg) for arg in args.ravel()],
+            rtol=1e-14,
+        )
+
+    @staticmethod
+    def test_array_conversions_non_contiguous():
+        # arrange
+        args = np.linspace(1e-9, 1e-6, 10)[::2]
+
+        # act
+        values = ppmc.rad2diam(args)
+
+        # assert
+        np.testing.assert_array_equal(values, 2 * args)